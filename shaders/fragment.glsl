@@ -8,18 +8,17 @@ out vec4 outScreenColor;
 uniform vec4 u_color;
 uniform vec4 u_fogColor;
 uniform vec3 u_viewPos;
+uniform float u_fogStart;
+uniform float u_fogDensity;
 
 uniform sampler2D u_texture;
 
 
 vec4 calcFog(vec4 color, float dist) {
-    const float fogStart = 2.0f;
-    const float fogDensity = 0.5f;
-
-    if (dist <= fogStart)
+    if (dist <= u_fogStart)
         return color;
 
-    float t = exp(-(dist - fogStart) * fogDensity);
+    float t = exp(-(dist - u_fogStart) * u_fogDensity);
 
     return mix(u_fogColor, color, 2*t - t*t);
 }
@@ -2,6 +2,8 @@
 
 layout (location=0) in vec3 v_pos;
 layout (location=1) in vec2 v_texCoord;
+// Per instance, 0 for meshes drawn on their own
+layout (location=2) in vec3 i_offset;
 
 out vec2 f_texCoord;
 out vec3 f_pos;
@@ -14,9 +16,9 @@ uniform mat4 u_projection;
 
 void main() {
     mat4 moveMatrix = u_translate * u_rotate;
-    mat4 fullMatrix = u_projection * u_view * moveMatrix;
-    gl_Position = fullMatrix * vec4(v_pos, 1.0f);
+    vec4 pos = moveMatrix * vec4(v_pos, 1.0f) + vec4(i_offset, 0.0f);
+    gl_Position = u_projection * u_view * pos;
 
     f_texCoord = v_texCoord;
-    f_pos = (moveMatrix * vec4(v_pos, 1.0f)).xyz;
+    f_pos = pos.xyz;
 }
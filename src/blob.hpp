@@ -0,0 +1,67 @@
+#pragma once
+
+#include "imports.hpp"
+
+
+namespace shrekrooms {
+
+
+// Appends plain values to a byte buffer in native (little endian) layout
+class BlobWriter {
+public:
+    BlobWriter(std::vector<uint8_t> &data) :
+        m_data(data) { }
+
+    template <typename _T>
+    void write(const _T &val) {
+        static_assert(std::is_trivially_copyable_v<_T>, "shrekrooms::BlobWriter::write needs a trivially copyable type");
+        const size_t offset = m_data.size();
+        m_data.resize(offset + sizeof(_T));
+        std::memcpy(m_data.data() + offset, &val, sizeof(_T));
+    }
+
+    void writeBytes(const void *data, size_t size) {
+        const size_t offset = m_data.size();
+        m_data.resize(offset + size);
+        std::memcpy(m_data.data() + offset, data, size);
+    }
+
+protected:
+    std::vector<uint8_t> &m_data;
+
+};
+
+
+// Reads back what BlobWriter wrote, throws instead of reading past the end
+class BlobReader {
+public:
+    BlobReader(const uint8_t *data, size_t size) :
+        m_ptr(data), m_end(data + size) { }
+
+    template <typename _T>
+    _T read() {
+        static_assert(std::is_trivially_copyable_v<_T>, "shrekrooms::BlobReader::read needs a trivially copyable type");
+        _T val;
+        readBytes(&val, sizeof(_T));
+        return val;
+    }
+
+    void readBytes(void *data, size_t size) {
+        if (size > getRemaining())
+            throw error { "blob.hpp", "shrekrooms::BlobReader::readBytes", "Unexpected end of data" };
+        std::memcpy(data, m_ptr, size);
+        m_ptr += size;
+    }
+
+    size_t getRemaining() const {
+        return static_cast<size_t>(m_end - m_ptr);
+    }
+
+protected:
+    const uint8_t *m_ptr;
+    const uint8_t *m_end;
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,148 @@
+#include "bot.hpp"
+#include "shrek.hpp"
+
+using namespace shrekrooms;
+
+
+static glm::vec2 toPlane(const glm::vec3 &pos) {
+    return { pos.x, pos.z };
+}
+
+// Bots only steer through the maze, which is small enough for world floats
+static glm::vec2 toPlane(const WorldPos &pos) {
+    return toPlane(pos.toWorld());
+}
+
+
+/*
+ * class shrekrooms::Bot
+*/
+
+Bot::Bot(ecs::EntityID entity, BotPolicy policy, rng::Random::Seed seed, ecs::EntityID target) :
+        m_entity(entity), m_policy(policy), m_target(target), m_random(seed),
+        m_goal(s_noGoal), m_cell(s_noGoal), m_nextPos(0.0f, 0.0f), m_holdTicks(0) {
+    if (policy == BotPolicy::Follow && target == ecs::nullEntity)
+        throw error { "bot.cpp", "shrekrooms::Bot::Bot", "Following bots need a target" };
+}
+
+ecs::EntityID Bot::getEntity() const {
+    return m_entity;
+}
+
+BotPolicy Bot::getPolicy() const {
+    return m_policy;
+}
+
+PlayerInput Bot::think(const ecs::Registry &registry, const World &world, float dt) {
+    if (!registry.has<ecs::Transform>(m_entity))
+        return {};
+
+    const ecs::Transform &transform = registry.get<ecs::Transform>(m_entity);
+    switch (m_policy) {
+        case BotPolicy::Wander:
+            return m_wander(world, transform, dt);
+        case BotPolicy::Follow:
+            return m_follow(registry, world, transform, dt);
+        case BotPolicy::RandomWalk:
+            return m_randomWalk(dt);
+    }
+    return {};
+}
+
+PlayerInput Bot::s_steerTowards(float rot, const glm::vec2 &diff, float dt) {
+    // Forward is (cos rot, sin rot) on the xz plane
+    const float angle = std::remainder(std::atan2(diff.y, diff.x) - rot, 360.0f * defines::deg2rad);
+    const float maxTurn = defines::bot::turnSpeed * dt;
+
+    PlayerInput input;
+    input.mouseDeltaX = glm::clamp(angle, -maxTurn, maxTurn) / (defines::player::mouseSensitivity * dt);
+    // Turn on the spot first so bots don't circle around their goal
+    input.forward = (std::abs(angle) < 45.0f * defines::deg2rad);
+    return input;
+}
+
+PlayerInput Bot::m_wander(const World &world, const ecs::Transform &transform, float dt) {
+    if (m_goal == s_noGoal || m_isArrived(toPlane(transform.pos))) {
+        const int maxCell = static_cast<int>(world.getMaze().getSize()) - 1;
+        rng::RandInt randCell = m_random.getRandInt(0, maxCell);
+        const int x = randCell.get();
+        return m_walkTo(world, transform, { x, randCell.get() }, dt);
+    }
+    return m_walkTo(world, transform, m_goal, dt);
+}
+
+PlayerInput Bot::m_follow(const ecs::Registry &registry, const World &world, const ecs::Transform &transform, float dt) {
+    if (!registry.has<ecs::Transform>(m_target))
+        return {};
+
+    const glm::vec2 pos = toPlane(transform.pos);
+    const glm::vec2 targetPos = toPlane(registry.get<ecs::Transform>(m_target).pos);
+    if (worldToChunkCoords(pos) == worldToChunkCoords(targetPos) || world.hasLineOfSight(pos, targetPos)) {
+        // The path is planned again once the target is out of sight
+        m_goal = s_noGoal;
+        if (glm::distance(pos, targetPos) < defines::bot::followDistance)
+            return {};
+        return s_steerTowards(transform.rot, targetPos - pos, dt);
+    }
+    return m_walkTo(world, transform, worldToChunkCoords(targetPos), dt);
+}
+
+PlayerInput Bot::m_randomWalk(float dt) {
+    if (m_holdTicks == 0) {
+        rng::RandInt randBool = m_random.getRandInt(0, 1);
+        m_held.forward = randBool.get();
+        m_held.backward = randBool.get();
+        m_held.left = randBool.get();
+        m_held.right = randBool.get();
+
+        const float turnRate = m_random.getRandFloat(-defines::bot::turnSpeed, defines::bot::turnSpeed).get();
+        m_held.mouseDeltaX = turnRate / defines::player::mouseSensitivity;
+
+        const float holdTime = m_random.getRandFloat(defines::bot::minHoldTime, defines::bot::maxHoldTime).get();
+        m_holdTicks = std::max<size_t>(1, static_cast<size_t>(holdTime / dt));
+    }
+
+    m_holdTicks--;
+    return m_held;
+}
+
+bool Bot::m_isArrived(const glm::vec2 &pos) const {
+    return m_path.empty() && glm::distance(pos, m_nextPos) < s_reachDist;
+}
+
+PlayerInput Bot::m_walkTo(const World &world, const ecs::Transform &transform, const glm::ivec2 &goal, float dt) {
+    const glm::vec2 pos = toPlane(transform.pos);
+    const glm::ivec2 cell = worldToChunkCoords(pos);
+
+    // Plan again for a new goal, or when pushed off the path by someone else
+    if (goal != m_goal || (cell != m_cell && cell != worldToChunkCoords(m_nextPos))) {
+        m_goal = goal;
+        m_cell = cell;
+        m_nextPos = pos;
+        findMazePath(world.getMaze(), cell, goal, m_path);
+    }
+
+    if (glm::distance(pos, m_nextPos) < s_reachDist) {
+        if (m_path.empty())
+            return {};
+        m_cell = cell;
+        m_nextPos = toPlane(chunkToWorldCoords(m_path.back()));
+        m_path.pop_back();
+    }
+
+    return s_steerTowards(transform.rot, m_nextPos - pos, dt);
+}
+
+
+void shrekrooms::updateBots(std::vector<Bot> &bots, const ecs::Registry &registry, const World &world, jobs::JobSystem &jobs, float dt, std::vector<PlayerInput> &inputs) {
+    for (const Bot &bot : bots) {
+        if (registry.has<ecs::Controller>(bot.getEntity()))
+            inputs.resize(std::max(inputs.size(), registry.get<ecs::Controller>(bot.getEntity()).inputIndex + 1));
+    }
+
+    jobs.parallelFor(0, bots.size(), 16, [&](size_t i) {
+        const PlayerInput input = bots[i].think(registry, world, dt);
+        if (registry.has<ecs::Controller>(bots[i].getEntity()))
+            inputs[registry.get<ecs::Controller>(bots[i].getEntity()).inputIndex] = input;
+    });
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "defines.hpp"
+#include "ecs.hpp"
+#include "jobs.hpp"
+#include "player.hpp"
+#include "rng.hpp"
+#include "world.hpp"
+
+
+namespace shrekrooms {
+
+
+enum class BotPolicy {
+    Wander,         // Walks the maze to one random cell after another
+    Follow,         // Keeps close to a target entity
+    RandomWalk,     // Holds random keys and turns for random lengths of time
+
+};
+
+
+/*
+ * Drives a Controller entity with the same PlayerInput a human would produce.
+ * Bots only read the registry, so a crowd of them thinks in parallel
+*/
+class Bot {
+public:
+    Bot(ecs::EntityID entity, BotPolicy policy, rng::Random::Seed seed, ecs::EntityID target = ecs::nullEntity);
+
+    ecs::EntityID getEntity() const;
+    BotPolicy getPolicy() const;
+
+    PlayerInput think(const ecs::Registry &registry, const World &world, float dt);
+
+protected:
+    static constexpr float s_reachDist = 0.5f;
+    static inline const glm::ivec2 s_noGoal { -1, -1 };
+
+    ecs::EntityID m_entity;
+    BotPolicy m_policy;
+    ecs::EntityID m_target;
+    rng::Random m_random;
+
+    // Path walking
+    glm::ivec2 m_goal;
+    glm::ivec2 m_cell;
+    glm::vec2 m_nextPos;
+    std::vector<glm::ivec2> m_path;
+
+    // Random walk
+    PlayerInput m_held;
+    size_t m_holdTicks;
+
+    static PlayerInput s_steerTowards(float rot, const glm::vec2 &diff, float dt);
+
+    PlayerInput m_wander(const World &world, const ecs::Transform &transform, float dt);
+    PlayerInput m_follow(const ecs::Registry &registry, const World &world, const ecs::Transform &transform, float dt);
+    PlayerInput m_randomWalk(float dt);
+
+    bool m_isArrived(const glm::vec2 &pos) const;
+    PlayerInput m_walkTo(const World &world, const ecs::Transform &transform, const glm::ivec2 &goal, float dt);
+
+};
+
+
+// Writes every bot's input to inputs[inputIndex] of its Controller, growing inputs as needed
+void updateBots(std::vector<Bot> &bots, const ecs::Registry &registry, const World &world, jobs::JobSystem &jobs, float dt, std::vector<PlayerInput> &inputs);
+
+
+} // namespace shrekrooms
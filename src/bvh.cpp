@@ -0,0 +1,557 @@
+#include "bvh.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * struct shrekrooms::RayHit
+*/
+
+RayHit::RayHit() :
+    isHit(false), dist(0.0f), normal(0.0f) { }
+
+RayHit::RayHit(float dist, const glm::vec2 &normal) :
+    isHit(true), dist(dist), normal(normal) { }
+
+
+/*
+ * class shrekrooms::WallBVH
+*/
+
+WallBVH::WallBVH() :
+    m_nodes(), m_primitives(), m_primitiveLeaves(), m_primitiveSpans(), m_dirtyLeaves(),
+    m_walls(), m_wallSpans(), m_freeWalls(), m_spans(), m_freeSpans() { }
+
+void WallBVH::build(const HitboxBatch &walls) {
+    m_nodes.clear();
+    m_walls.clear();
+    m_freeWalls.clear();
+    m_spans.clear();
+    m_freeSpans.clear();
+
+    m_walls.reserve(walls.size());
+    for (size_t i = 0; i < walls.size(); i++)
+        m_walls.push_back(walls.get(i));
+    m_wallSpans.assign(m_walls.size(), s_noSpan);
+
+    m_mergeSpans();
+    m_buildTree();
+}
+
+size_t WallBVH::getSpanCount() const {
+    return m_spans.size() - m_freeSpans.size();
+}
+
+size_t WallBVH::addWall(const Hitbox &wall) {
+    static const float tolerance = 10.0f * defines::epsilon;
+
+    uint32_t added;
+    if (m_freeWalls.empty()) {
+        added = m_walls.size();
+        m_walls.push_back(wall);
+        m_wallSpans.push_back(s_noSpan);
+    } else {
+        added = m_freeWalls.back();
+        m_freeWalls.pop_back();
+        m_walls[added] = wall;
+    }
+
+    // Spans the wall continues on either side, found with up to date bounds
+    refit();
+    const int axis = s_getAxis(wall);
+    const glm::vec2 reach { tolerance, tolerance };
+    const Hitbox area { wall.posMin - reach, wall.posMax + reach };
+    std::vector<uint32_t> joined;
+
+    uint32_t stack[64];
+    size_t top = 0;
+    if (!m_nodes.empty())
+        stack[top++] = 0;
+
+    while (top != 0) {
+        const uint32_t id = stack[--top];
+        const Node &node = m_nodes[id];
+        const Hitbox &bounds = node.bounds;
+        if (bounds.posMax.x < area.posMin.x || bounds.posMax.y < area.posMin.y || area.posMax.x < bounds.posMin.x || area.posMax.y < bounds.posMin.y)
+            continue;
+
+        if (node.count == 0) {
+            stack[top++] = id + 1;
+            stack[top++] = node.right;
+            continue;
+        }
+
+        for (uint32_t i = node.begin; i < node.begin + node.count; i++) {
+            const uint32_t span = m_primitiveSpans[i];
+            if (span == s_noSpan || m_spans[span].axis != axis)
+                continue;
+            const Hitbox spanBounds = m_primitives.get(i);
+            if (s_isJoined(spanBounds, wall, axis) && s_isJoined(wall, spanBounds, axis))
+                joined.push_back(span);
+        }
+    }
+
+    std::vector<uint32_t> walls { added };
+    for (uint32_t span : joined)
+        walls.insert(walls.end(), m_spans[span].walls.begin(), m_spans[span].walls.end());
+    std::sort(walls.begin(), walls.end(), [this, axis](uint32_t w1, uint32_t w2) {
+        return m_walls[w1].posMin[axis] < m_walls[w2].posMin[axis];
+    });
+
+    // The first span joined keeps its slot, the others are freed
+    const uint32_t span = joined.empty() ? m_newSpan(axis) : joined[0];
+    for (size_t i = 1; i < joined.size(); i++)
+        m_freeSpan(joined[i]);
+    m_setSpanWalls(span, walls);
+    if (m_nodes.empty())
+        m_buildTree();
+    return added;
+}
+
+void WallBVH::removeWall(size_t wall) {
+    const uint32_t span = m_wallSpans[wall];
+    if (span == s_noSpan)
+        throw error { "bvh.cpp", "shrekrooms::WallBVH::removeWall", "The wall was removed already" };
+    m_wallSpans[wall] = s_noSpan;
+    m_freeWalls.push_back(wall);
+
+    std::vector<uint32_t> walls = m_spans[span].walls;
+    walls.erase(std::find(walls.begin(), walls.end(), wall));
+    if (walls.empty())
+        m_freeSpan(span);
+    else
+        m_setSpanWalls(span, walls);
+}
+
+void WallBVH::refit() {
+    for (uint32_t leaf : m_dirtyLeaves) {
+        m_nodes[leaf].dirty = false;
+        m_refitNode(leaf);
+
+        // Stop as soon as a parent keeps its bounds, nothing above it can change
+        for (uint32_t node = m_nodes[leaf].parent; node != s_noNode; node = m_nodes[node].parent) {
+            const Hitbox old = m_nodes[node].bounds;
+            m_refitNode(node);
+            const Hitbox &bounds = m_nodes[node].bounds;
+            if (bounds.posMin == old.posMin && bounds.posMax == old.posMax)
+                break;
+        }
+    }
+    m_dirtyLeaves.clear();
+}
+
+void WallBVH::addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius) const {
+    if (m_nodes.empty())
+        return;
+
+    uint32_t stack[64];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top != 0) {
+        const uint32_t id = stack[--top];
+        const Node &node = m_nodes[id];
+
+        glm::vec2 diff = pos - glm::clamp(pos, node.bounds.posMin, node.bounds.posMax);
+        if (glm::dot(diff, diff) > radius*radius)
+            continue;
+
+        if (node.count != 0) {
+            m_primitives.addCircleIntersections(coll, pos, radius, node.begin, node.begin + node.count);
+            continue;
+        }
+        stack[top++] = id + 1;
+        stack[top++] = node.right;
+    }
+}
+
+RayHit WallBVH::raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const {
+    RayHit res { };
+    if (m_nodes.empty())
+        return res;
+
+    // Zero components become infinities, s_rayHitbox treats them as parallel slabs
+    const glm::vec2 invDir { 1.0f / dir.x, 1.0f / dir.y };
+
+    uint32_t stack[64];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top != 0) {
+        const uint32_t id = stack[--top];
+        const Node &node = m_nodes[id];
+
+        float dist;
+        int axis;
+        if (!s_rayHitbox(node.bounds, origin, invDir, (res.isHit ? res.dist : maxDist), dist, axis))
+            continue;
+
+        if (node.count == 0) {
+            stack[top++] = id + 1;
+            stack[top++] = node.right;
+            continue;
+        }
+
+        for (uint32_t i = node.begin; i < node.begin + node.count; i++) {
+            if (!s_rayHitbox(m_primitives.get(i), origin, invDir, (res.isHit ? res.dist : maxDist), dist, axis))
+                continue;
+
+            glm::vec2 normal { 0.0f, 0.0f };
+            if (axis >= 0)
+                normal[axis] = (invDir[axis] > 0.0f) ? -1.0f : 1.0f;
+            res = { dist, normal };
+        }
+    }
+
+    return res;
+}
+
+RayHit WallBVH::sweepCircle(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist, float radius) const {
+    RayHit res { };
+    if (m_nodes.empty())
+        return res;
+
+    const glm::vec2 invDir { 1.0f / dir.x, 1.0f / dir.y };
+    const glm::vec2 inflate { radius, radius };
+
+    uint32_t stack[64];
+    size_t top = 0;
+    stack[top++] = 0;
+
+    while (top != 0) {
+        const uint32_t id = stack[--top];
+        const Node &node = m_nodes[id];
+
+        float dist;
+        int axis;
+        const Hitbox bounds { node.bounds.posMin - inflate, node.bounds.posMax + inflate };
+        if (!s_rayHitbox(bounds, origin, invDir, (res.isHit ? res.dist : maxDist), dist, axis))
+            continue;
+
+        if (node.count == 0) {
+            stack[top++] = id + 1;
+            stack[top++] = node.right;
+            continue;
+        }
+
+        for (uint32_t i = node.begin; i < node.begin + node.count; i++) {
+            RayHit hit;
+            if (s_sweepCircleHitbox(m_primitives.get(i), origin, dir, invDir, (res.isHit ? res.dist : maxDist), radius, hit))
+                res = hit;
+        }
+    }
+
+    return res;
+}
+
+int WallBVH::s_getAxis(const Hitbox &wall) {
+    const glm::vec2 size = wall.getSize();
+    return (size.x >= size.y) ? 0 : 1;
+}
+
+bool WallBVH::s_isJoined(const Hitbox &span, const Hitbox &wall, int axis) {
+    // Walls on one line differ by the z-fighting epsilon at most, distinct lines are a wall thickness apart
+    static const float tolerance = 10.0f * defines::epsilon;
+
+    const int across = 1 - axis;
+    const bool sameLine = std::abs(wall.getCenter()[across] - span.getCenter()[across]) <= tolerance;
+    const bool sameThickness = std::abs(wall.getSize()[across] - span.getSize()[across]) <= tolerance;
+    return sameLine && sameThickness && wall.posMin[axis] <= span.posMax[axis] + tolerance;
+}
+
+bool WallBVH::s_rayHitbox(const Hitbox &hitbox, const glm::vec2 &origin, const glm::vec2 &invDir, float maxDist, float &dist, int &axis) {
+    float tMin = 0.0f;
+    float tMax = maxDist;
+    axis = -1;
+
+    for (int a = 0; a < 2; a++) {
+        if (hitbox.posMin[a] > hitbox.posMax[a])
+            return false;
+
+        if (std::isinf(invDir[a])) {
+            if (origin[a] < hitbox.posMin[a] || origin[a] > hitbox.posMax[a])
+                return false;
+            continue;
+        }
+
+        float t1 = (hitbox.posMin[a] - origin[a]) * invDir[a];
+        float t2 = (hitbox.posMax[a] - origin[a]) * invDir[a];
+        if (t1 > t2)
+            std::swap(t1, t2);
+
+        if (t1 > tMin) {
+            tMin = t1;
+            axis = a;
+        }
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+
+    dist = tMin;
+    return true;
+}
+
+bool WallBVH::s_sweepCircleHitbox(const Hitbox &hitbox, const glm::vec2 &origin, const glm::vec2 &dir, const glm::vec2 &invDir, float maxDist, float radius, RayHit &hit) {
+    // Ray against the rectangle grown by radius, then rounded off at the corners
+    const glm::vec2 inflate { radius, radius };
+    float dist;
+    int axis;
+    if (!s_rayHitbox({ hitbox.posMin - inflate, hitbox.posMax + inflate }, origin, invDir, maxDist, dist, axis))
+        return false;
+
+    const glm::vec2 entry = origin + dir * dist;
+    const bool outsideX = (entry.x < hitbox.posMin.x || entry.x > hitbox.posMax.x);
+    const bool outsideY = (entry.y < hitbox.posMin.y || entry.y > hitbox.posMax.y);
+
+    if (outsideX && outsideY) {
+        const glm::vec2 corner {
+            (entry.x < hitbox.posMin.x) ? hitbox.posMin.x : hitbox.posMax.x,
+            (entry.y < hitbox.posMin.y) ? hitbox.posMin.y : hitbox.posMax.y
+        };
+        const glm::vec2 m = origin - corner;
+        const float b = glm::dot(m, dir);
+        const float c = glm::dot(m, m) - radius*radius;
+
+        // Already touching the corner, only block movement towards it
+        if (c <= 0.0f) {
+            if (b >= 0.0f || glm::dot(m, m) == 0.0f)
+                return false;
+            hit = { 0.0f, glm::normalize(m) };
+            return true;
+        }
+
+        const float disc = b*b - c;
+        if (b > 0.0f || disc < 0.0f)
+            return false;
+
+        dist = -b - std::sqrt(disc);
+        if (dist > maxDist)
+            return false;
+
+        hit = { dist, (origin + dir * dist - corner) / radius };
+        return true;
+    }
+
+    // Started inside the grown rectangle next to a face
+    if (axis < 0) {
+        const glm::vec2 diff = origin - glm::clamp(origin, hitbox.posMin, hitbox.posMax);
+        if (glm::dot(diff, dir) >= 0.0f || glm::dot(diff, diff) == 0.0f)
+            return false;
+        hit = { 0.0f, glm::normalize(diff) };
+        return true;
+    }
+
+    glm::vec2 normal { 0.0f, 0.0f };
+    normal[axis] = (invDir[axis] > 0.0f) ? -1.0f : 1.0f;
+    hit = { dist, normal };
+    return true;
+}
+
+void WallBVH::m_mergeSpans() {
+    static const float tolerance = 10.0f * defines::epsilon;
+
+    // 0: spans along x, 1: spans along z
+    std::array<std::vector<uint32_t>, 2> lines;
+    for (uint32_t i = 0; i < m_walls.size(); i++)
+        lines[s_getAxis(m_walls[i])].push_back(i);
+
+    for (int axis = 0; axis < 2; axis++) {
+        const int across = 1 - axis;
+        std::vector<uint32_t> &group = lines[axis];
+
+        std::sort(group.begin(), group.end(), [this, across](uint32_t w1, uint32_t w2) {
+            return m_walls[w1].getCenter()[across] < m_walls[w2].getCenter()[across];
+        });
+
+        size_t lineBegin = 0;
+        for (size_t i = 1; i <= group.size(); i++) {
+            if (i < group.size() && m_walls[group[i]].getCenter()[across] - m_walls[group[i - 1]].getCenter()[across] <= tolerance)
+                continue;
+
+            // [lineBegin; i) lie on one line, m_setSpanWalls() joins the ones that touch
+            std::sort(group.begin() + lineBegin, group.begin() + i, [this, axis](uint32_t w1, uint32_t w2) {
+                return m_walls[w1].posMin[axis] < m_walls[w2].posMin[axis];
+            });
+            m_setSpanWalls(m_newSpan(axis), { group.begin() + lineBegin, group.begin() + i });
+            lineBegin = i;
+        }
+    }
+}
+
+Hitbox WallBVH::m_getSpanBounds(uint32_t span) const {
+    Hitbox bounds = Hitbox::empty();
+    for (uint32_t wall : m_spans[span].walls)
+        bounds = bounds.merge(m_walls[wall]);
+    return bounds;
+}
+
+uint32_t WallBVH::m_newSpan(int axis) {
+    uint32_t span;
+    if (m_freeSpans.empty()) {
+        span = m_spans.size();
+        m_spans.emplace_back();
+    } else {
+        span = m_freeSpans.back();
+        m_freeSpans.pop_back();
+    }
+    m_spans[span] = { axis, {}, s_noSpan };
+    return span;
+}
+
+void WallBVH::m_freeSpan(uint32_t span) {
+    const uint32_t slot = m_spans[span].slot;
+    if (slot != s_noSpan) {
+        m_setPrimitive(slot, Hitbox::empty());
+        m_primitiveSpans[slot] = s_noSpan;
+    }
+    m_spans[span].walls.clear();
+    m_spans[span].slot = s_noSpan;
+    m_freeSpans.push_back(span);
+}
+
+void WallBVH::m_setSpanWalls(uint32_t span, const std::vector<uint32_t> &walls) {
+    const int axis = m_spans[span].axis;
+
+    size_t runBegin = 0;
+    Hitbox bounds = m_walls[walls[0]];
+    for (size_t i = 1; i <= walls.size(); i++) {
+        if (i < walls.size() && s_isJoined(bounds, m_walls[walls[i]], axis)) {
+            bounds = bounds.merge(m_walls[walls[i]]);
+            continue;
+        }
+
+        const uint32_t run = (runBegin == 0) ? span : m_newSpan(axis);
+        m_spans[run].walls.assign(walls.begin() + runBegin, walls.begin() + i);
+        for (uint32_t wall : m_spans[run].walls)
+            m_wallSpans[wall] = run;
+
+        // Without a tree, spans are placed by the next m_buildTree()
+        if (m_spans[run].slot != s_noSpan)
+            m_setPrimitive(m_spans[run].slot, bounds);
+        else if (!m_nodes.empty())
+            m_insertSpan(run);
+
+        if (i < walls.size())
+            bounds = m_walls[walls[i]];
+        runBegin = i;
+    }
+}
+
+void WallBVH::m_insertSpan(uint32_t span) {
+    const Hitbox bounds = m_getSpanBounds(span);
+    const auto getHalfPerimeter = [](const Hitbox &hitbox) {
+        const glm::vec2 size = hitbox.getSize();
+        return (size.x < 0.0f) ? 0.0f : size.x + size.y;
+    };
+
+    uint32_t bestSlot = s_noSpan;
+    float bestGrowth = std::numeric_limits<float>::infinity();
+    for (const Node &leaf : m_nodes) {
+        if (leaf.count == 0)
+            continue;
+        for (uint32_t i = leaf.begin; i < leaf.begin + leaf.count; i++) {
+            if (m_primitiveSpans[i] != s_noSpan)
+                continue;
+            const float growth = getHalfPerimeter(leaf.bounds.merge(bounds)) - getHalfPerimeter(leaf.bounds);
+            if (growth < bestGrowth) {
+                bestGrowth = growth;
+                bestSlot = i;
+            }
+            break;
+        }
+    }
+
+    if (bestSlot == s_noSpan) {
+        m_buildTree();
+        return;
+    }
+    m_spans[span].slot = bestSlot;
+    m_primitiveSpans[bestSlot] = span;
+    m_setPrimitive(bestSlot, bounds);
+}
+
+void WallBVH::m_setPrimitive(uint32_t slot, const Hitbox &hitbox) {
+    m_primitives.set(slot, hitbox);
+
+    Node &leaf = m_nodes[m_primitiveLeaves[slot]];
+    if (!leaf.dirty) {
+        leaf.dirty = true;
+        m_dirtyLeaves.push_back(m_primitiveLeaves[slot]);
+    }
+}
+
+void WallBVH::m_buildTree() {
+    m_nodes.clear();
+    m_primitives.clear();
+    m_primitiveLeaves.clear();
+    m_primitiveSpans.clear();
+    m_dirtyLeaves.clear();
+
+    std::vector<uint32_t> spans;
+    std::vector<Hitbox> bounds(m_spans.size(), Hitbox::empty());
+    for (uint32_t span = 0; span < m_spans.size(); span++) {
+        if (m_spans[span].walls.empty())
+            continue;
+        spans.push_back(span);
+        bounds[span] = m_getSpanBounds(span);
+    }
+    if (spans.empty())
+        return;
+
+    m_nodes.reserve(2 * (spans.size() / s_leafSize + 1));
+    m_primitives.reserve(2 * spans.size());
+    m_buildNode(spans, bounds, 0, spans.size(), s_noNode);
+}
+
+uint32_t WallBVH::m_buildNode(std::vector<uint32_t> &spans, const std::vector<Hitbox> &bounds, uint32_t begin, uint32_t end, uint32_t parent) {
+    const uint32_t id = m_nodes.size();
+    m_nodes.push_back({ Hitbox::empty(), parent, s_noNode, 0, 0, false });
+
+    Hitbox centers = Hitbox::empty();
+    for (uint32_t i = begin; i < end; i++) {
+        m_nodes[id].bounds = m_nodes[id].bounds.merge(bounds[spans[i]]);
+        glm::vec2 center = bounds[spans[i]].getCenter();
+        centers = centers.merge({ center, center });
+    }
+
+    if (end - begin <= s_leafSize) {
+        // Slots past the spans stay free for spans split off later
+        m_nodes[id].begin = m_primitives.size();
+        m_nodes[id].count = s_leafSize;
+        for (uint32_t i = 0; i < s_leafSize; i++) {
+            const uint32_t span = (begin + i < end) ? spans[begin + i] : s_noSpan;
+            if (span != s_noSpan)
+                m_spans[span].slot = m_primitives.size();
+            m_primitiveLeaves.push_back(id);
+            m_primitiveSpans.push_back(span);
+            m_primitives.push((span != s_noSpan) ? bounds[span] : Hitbox::empty());
+        }
+        return id;
+    }
+
+    // Median split along the longest axis of the centres
+    glm::vec2 extent = centers.getSize();
+    const int axis = (extent.x >= extent.y) ? 0 : 1;
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(spans.begin() + begin, spans.begin() + mid, spans.begin() + end, [&bounds, axis](uint32_t s1, uint32_t s2) {
+        return bounds[s1].getCenter()[axis] < bounds[s2].getCenter()[axis];
+    });
+
+    m_buildNode(spans, bounds, begin, mid, id);
+    const uint32_t right = m_buildNode(spans, bounds, mid, end, id);
+    m_nodes[id].right = right;
+    return id;
+}
+
+void WallBVH::m_refitNode(uint32_t node) {
+    Node &n = m_nodes[node];
+    if (n.count == 0) {
+        n.bounds = m_nodes[node + 1].bounds.merge(m_nodes[n.right].bounds);
+        return;
+    }
+
+    n.bounds = Hitbox::empty();
+    for (uint32_t i = n.begin; i < n.begin + n.count; i++)
+        n.bounds = n.bounds.merge(m_primitives.get(i));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "defines.hpp"
+#include "collision.hpp"
+
+
+namespace shrekrooms {
+
+
+struct RayHit {
+    bool isHit;
+    float dist;
+    glm::vec2 normal;
+
+    RayHit();
+    RayHit(float dist, const glm::vec2 &normal);
+
+};
+
+
+/*
+ * Wall set: collinear hitboxes are merged into maximal spans,
+ * which are then stored in a bounding volume hierarchy.
+ * Every wall remembers its span, so opening one splits its span and closing one
+ * joins the spans it touches. Leaves keep spare slots for the spans this creates
+*/
+class WallBVH {
+public:
+    static constexpr size_t s_leafSize = HitboxBatch::s_laneCount;
+
+    WallBVH();
+
+    // Wall ids are the indices in walls
+    void build(const HitboxBatch &walls);
+
+    size_t getSpanCount() const;
+
+    // Changes are applied to the tree on the next refit().
+    // Pending changes are refit before a new wall looks for the spans it touches
+    size_t addWall(const Hitbox &wall);
+    void removeWall(size_t wall);
+    void refit();
+
+    void addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius) const;
+    // dir has to be normalized
+    RayHit raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const;
+    // Time of impact of a circle moving along dir, res.dist is measured along dir
+    RayHit sweepCircle(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist, float radius) const;
+
+protected:
+    static constexpr uint32_t s_noNode = UINT32_MAX;
+    static constexpr uint32_t s_noSpan = UINT32_MAX;
+
+    struct Node {
+        Hitbox bounds;
+        uint32_t parent;
+        uint32_t right;     // Left child always follows its parent
+        uint32_t begin;
+        uint32_t count;     // Leaf if not 0, always s_leafSize slots
+        bool dirty;
+    };
+
+    struct Span {
+        int axis;                       // 0: along x, 1: along z
+        std::vector<uint32_t> walls;    // Sorted along axis, empty if the span is free
+        uint32_t slot;
+    };
+
+    std::vector<Node> m_nodes;
+    HitboxBatch m_primitives;   // Span bounds in leaf order, free slots are empty
+    std::vector<uint32_t> m_primitiveLeaves;
+    std::vector<uint32_t> m_primitiveSpans;
+    std::vector<uint32_t> m_dirtyLeaves;
+
+    std::vector<Hitbox> m_walls;
+    std::vector<uint32_t> m_wallSpans;  // s_noSpan once removed
+    std::vector<uint32_t> m_freeWalls;
+    std::vector<Span> m_spans;
+    std::vector<uint32_t> m_freeSpans;
+
+    static int s_getAxis(const Hitbox &wall);
+    // Whether wall continues span on its line
+    static bool s_isJoined(const Hitbox &span, const Hitbox &wall, int axis);
+    static bool s_rayHitbox(const Hitbox &hitbox, const glm::vec2 &origin, const glm::vec2 &invDir, float maxDist, float &dist, int &axis);
+    static bool s_sweepCircleHitbox(const Hitbox &hitbox, const glm::vec2 &origin, const glm::vec2 &dir, const glm::vec2 &invDir, float maxDist, float radius, RayHit &hit);
+
+    void m_mergeSpans();
+    Hitbox m_getSpanBounds(uint32_t span) const;
+    uint32_t m_newSpan(int axis);
+    void m_freeSpan(uint32_t span);
+    // Splits the sorted walls into runs that touch, the first run stays in span
+    void m_setSpanWalls(uint32_t span, const std::vector<uint32_t> &walls);
+    // Into the free slot that grows its leaf the least, rebuilds the tree if none is left
+    void m_insertSpan(uint32_t span);
+    void m_setPrimitive(uint32_t slot, const Hitbox &hitbox);
+
+    void m_buildTree();
+    uint32_t m_buildNode(std::vector<uint32_t> &spans, const std::vector<Hitbox> &bounds, uint32_t begin, uint32_t end, uint32_t parent);
+    void m_refitNode(uint32_t node);
+
+};
+
+
+} // namespace shrekrooms
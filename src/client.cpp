@@ -0,0 +1,235 @@
+#include "client.hpp"
+
+using namespace shrekrooms::net;
+
+
+/*
+ * class shrekrooms::net::Client
+*/
+
+Client::Client(const World &world, rng::Random::Seed seed, jobs::JobSystem &jobs, uint16_t serverPort) :
+    m_seed(seed), m_server(Address::s_loopback(serverPort)), m_isConnected(false),
+    m_serverEntity(ecs::nullEntity), m_predictedEntity(ecs::nullEntity), m_prediction(world, jobs),
+    m_nextSeq(1), m_partial { noTick, noTick, 0, { }, 0 }, m_stats() { }
+
+Client::~Client() {
+    if (!m_isConnected)
+        return;
+
+    // Saves the server waiting for the timeout, losing it is harmless
+    try {
+        m_packet.clear();
+        BlobWriter writer { m_packet };
+        writeHeader(writer, PacketType::Disconnect);
+        m_socket.send(m_server, m_packet);
+    } catch (const error &) { }
+}
+
+bool Client::isConnected() const {
+    return m_isConnected;
+}
+
+bool Client::hasState() const {
+    return m_predictedEntity != ecs::nullEntity;
+}
+
+shrekrooms::ecs::EntityID Client::getServerEntity() const {
+    return m_serverEntity;
+}
+
+shrekrooms::ecs::EntityID Client::getPredictedEntity() const {
+    return m_predictedEntity;
+}
+
+const shrekrooms::Simulation &Client::getPrediction() const {
+    return m_prediction;
+}
+
+const shrekrooms::SimSnapshot &Client::getView() const {
+    static const SimSnapshot empty { noTick, { } };
+    return m_history.empty() ? empty : m_history.back();
+}
+
+void Client::tick(const PlayerInput &input) {
+    m_receive();
+
+    if (!m_isConnected) {
+        const float sinceAttempt = std::chrono::duration_cast<DurationSecondsFloat>(Clock::now() - m_lastConnectAttempt).count();
+        if (sinceAttempt >= defines::net::connectRetry)
+            m_sendConnect();
+        return;
+    }
+
+    m_pendingInputs.emplace_back(m_nextSeq++, input);
+    // The server stopped applying them, replaying more would only cost time
+    while (m_pendingInputs.size() > defines::net::snapshotHistory)
+        m_pendingInputs.pop_front();
+
+    if (hasState())
+        m_prediction.tick(input);
+
+    m_sendInputs();
+}
+
+const Client::Stats &Client::getStats() const {
+    return m_stats;
+}
+
+void Client::resetStats() {
+    m_stats = {};
+}
+
+void Client::m_receive() {
+    Address from;
+    while (m_socket.receive(from, m_received)) {
+        if (from != m_server)
+            continue;
+        m_stats.bytesReceived += m_received.size();
+
+        BlobReader reader { m_received.data(), m_received.size() };
+        PacketType type;
+        if (!readHeader(reader, type))
+            continue;
+
+        bool isOtherWorld = false;
+        try {
+            if (type == PacketType::Welcome)
+                isOtherWorld = !m_onWelcome(reader);
+            else if (type == PacketType::Snapshot && m_isConnected)
+                m_onSnapshotFragment(reader);
+        }
+        catch (const error &) {
+            // A malformed packet is dropped like a lost one
+            continue;
+        }
+        if (isOtherWorld)
+            throw error { "client.cpp", "shrekrooms::net::Client::m_receive", "The server runs a world from another seed" };
+    }
+}
+
+bool Client::m_onWelcome(BlobReader &reader) {
+    if (m_isConnected)
+        return true;
+
+    if (reader.read<rng::Random::Seed>() != m_seed)
+        return false;
+    const ecs::EntityID entity = reader.read<ecs::EntityID>();
+    const uint64_t tick = reader.read<uint64_t>();
+    m_serverEntity = entity;
+    m_prediction.restoreTick(tick);
+    m_isConnected = true;
+    return true;
+}
+
+void Client::m_onSnapshotFragment(BlobReader &reader) {
+    const uint64_t tick = reader.read<uint64_t>();
+    const uint64_t baseTick = reader.read<uint64_t>();
+    const uint32_t appliedSeq = reader.read<uint32_t>();
+    const uint16_t index = reader.read<uint16_t>();
+    const uint16_t count = reader.read<uint16_t>();
+    if (index >= count || reader.getRemaining() == 0)
+        throw error { "client.cpp", "shrekrooms::net::Client::m_onSnapshotFragment", "Malformed snapshot fragment" };
+
+    // Out of order, a newer one was applied already
+    if (!m_history.empty() && tick <= m_history.back().tick)
+        return;
+
+    // A newer snapshot replaces an incomplete one, whose missing fragments may never come
+    if (m_partial.tick == noTick || tick > m_partial.tick) {
+        m_partial.tick = tick;
+        m_partial.baseTick = baseTick;
+        m_partial.appliedSeq = appliedSeq;
+        m_partial.fragments.assign(count, { });
+        m_partial.missing = count;
+    }
+    if (tick != m_partial.tick || !m_partial.fragments[index].empty())
+        return;
+    if (count != m_partial.fragments.size() || baseTick != m_partial.baseTick)
+        throw error { "client.cpp", "shrekrooms::net::Client::m_onSnapshotFragment", "Fragment doesn't match the others of its snapshot" };
+
+    std::vector<uint8_t> &fragment = m_partial.fragments[index];
+    fragment.resize(reader.getRemaining());
+    reader.readBytes(fragment.data(), fragment.size());
+    if (--m_partial.missing != 0)
+        return;
+
+    m_assembled.clear();
+    for (const std::vector<uint8_t> &part : m_partial.fragments)
+        m_assembled.insert(m_assembled.end(), part.begin(), part.end());
+    m_partial.tick = noTick;
+
+    BlobReader assembled { m_assembled.data(), m_assembled.size() };
+    m_onSnapshot(tick, baseTick, m_partial.appliedSeq, assembled);
+}
+
+void Client::m_onSnapshot(uint64_t tick, uint64_t baseTick, uint32_t appliedSeq, BlobReader &reader) {
+    const SimSnapshot *base = nullptr;
+    if (baseTick != noTick) {
+        auto it = std::find_if(m_history.begin(), m_history.end(), [baseTick](const SimSnapshot &snapshot) {
+            return snapshot.tick == baseTick;
+        });
+        // Can't be decoded, the next one will be against a base still held
+        if (it == m_history.end())
+            return;
+        base = &*it;
+    }
+
+    SimSnapshot snapshot { tick, { } };
+    readSnapshotDelta(reader, base, snapshot);
+    m_history.push_back(std::move(snapshot));
+    while (m_history.size() > defines::net::snapshotHistory)
+        m_history.pop_front();
+    m_stats.snapshots++;
+
+    const EntitySnapshot *state = m_history.back().find(m_serverEntity);
+    if (state)
+        m_reconcile(*state, appliedSeq);
+}
+
+void Client::m_reconcile(const EntitySnapshot &state, uint32_t appliedSeq) {
+    while (!m_pendingInputs.empty() && m_pendingInputs.front().first <= appliedSeq)
+        m_pendingInputs.pop_front();
+
+    const bool hadState = hasState();
+    ecs::Registry &registry = m_prediction.getRegistry();
+    if (!hadState)
+        m_predictedEntity = spawnPlayer(registry, state.pos, state.rot, 0);
+
+    const WorldPos predictedPos = registry.get<ecs::Transform>(m_predictedEntity).pos;
+    registry.get<ecs::Transform>(m_predictedEntity) = { state.pos, state.rot };
+    for (const auto &[seq, input] : m_pendingInputs)
+        m_prediction.tick(input);
+
+    const float correction = glm::length(registry.get<ecs::Transform>(m_predictedEntity).pos.relativeTo(predictedPos));
+    if (hadState && correction > defines::epsilon) {
+        m_stats.corrections++;
+        m_stats.correctionSum += correction;
+        m_stats.maxCorrection = std::max(m_stats.maxCorrection, correction);
+    }
+}
+
+void Client::m_sendConnect() {
+    m_packet.clear();
+    BlobWriter writer { m_packet };
+    writeHeader(writer, PacketType::Connect);
+
+    m_socket.send(m_server, m_packet);
+    m_stats.bytesSent += m_packet.size();
+    m_lastConnectAttempt = Clock::now();
+}
+
+void Client::m_sendInputs() {
+    const size_t count = std::min(m_pendingInputs.size(), defines::net::inputRedundancy);
+
+    m_packet.clear();
+    BlobWriter writer { m_packet };
+    writeHeader(writer, PacketType::Input);
+    writer.write<uint64_t>(m_history.empty() ? noTick : m_history.back().tick);
+    writer.write<uint32_t>(count ? m_pendingInputs[m_pendingInputs.size() - count].first : m_nextSeq);
+    writer.write<uint8_t>(static_cast<uint8_t>(count));
+    for (size_t i = m_pendingInputs.size() - count; i < m_pendingInputs.size(); i++)
+        writeInput(writer, m_pendingInputs[i].second);
+
+    m_socket.send(m_server, m_packet);
+    m_stats.bytesSent += m_packet.size();
+}
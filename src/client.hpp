@@ -0,0 +1,100 @@
+#pragma once
+
+#include "defines.hpp"
+#include "net.hpp"
+#include "net_protocol.hpp"
+#include "simulation.hpp"
+
+
+namespace shrekrooms::net {
+
+
+/*
+ * Connection to a Server. The own player is predicted locally from the inputs sent,
+ * and every snapshot resets it to the server's state and replays the inputs the server
+ * hasn't applied yet. Everything else is shown as the server last sent it
+*/
+class Client {
+public:
+    struct Stats {
+        size_t snapshots;
+        size_t bytesSent;
+        size_t bytesReceived;
+        size_t corrections;     // Reconciliations that moved the predicted player
+        float correctionSum;    // Distance moved, summed over them
+        float maxCorrection;
+
+    };
+
+    // world has to be generated from seed, the server's seed is checked against it
+    Client(const World &world, rng::Random::Seed seed, jobs::JobSystem &jobs, uint16_t serverPort);
+    ~Client();
+
+    Client(const Client &) = delete;
+    Client &operator =(const Client &) = delete;
+
+    bool isConnected() const;
+    // False until the first snapshot with the own player arrived
+    bool hasState() const;
+
+    // Own player in the server's snapshots
+    ecs::EntityID getServerEntity() const;
+    // Own player in getPrediction()
+    ecs::EntityID getPredictedEntity() const;
+    const Simulation &getPrediction() const;
+    // Latest state received from the server, the entities near the own player
+    const SimSnapshot &getView() const;
+
+    // Handles every waiting packet, then predicts one tick with input and sends it
+    void tick(const PlayerInput &input);
+
+    const Stats &getStats() const;
+    void resetStats();
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    // Fragments of the newest snapshot still arriving
+    struct PartialSnapshot {
+        uint64_t tick;
+        uint64_t baseTick;
+        uint32_t appliedSeq;
+        std::vector<std::vector<uint8_t>> fragments;    // Empty until received
+        size_t missing;
+
+    };
+
+    rng::Random::Seed m_seed;
+    UdpSocket m_socket;
+    Address m_server;
+    bool m_isConnected;
+    Clock::time_point m_lastConnectAttempt;
+
+    ecs::EntityID m_serverEntity;
+    ecs::EntityID m_predictedEntity;
+    Simulation m_prediction;
+
+    uint32_t m_nextSeq;
+    std::deque<std::pair<uint32_t, PlayerInput>> m_pendingInputs;  // Not yet applied by the server
+    std::deque<SimSnapshot> m_history;                              // Delta bases, the latest at the back
+    PartialSnapshot m_partial;
+
+    std::vector<uint8_t> m_received;
+    std::vector<uint8_t> m_assembled;
+    std::vector<uint8_t> m_packet;
+    Stats m_stats;
+
+    void m_receive();
+    // False if the server runs a world from another seed
+    bool m_onWelcome(BlobReader &reader);
+    void m_onSnapshotFragment(BlobReader &reader);
+    // Once every fragment arrived
+    void m_onSnapshot(uint64_t tick, uint64_t baseTick, uint32_t appliedSeq, BlobReader &reader);
+    void m_reconcile(const EntitySnapshot &state, uint32_t appliedSeq);
+    void m_sendConnect();
+    void m_sendInputs();
+
+};
+
+
+} // namespace shrekrooms::net
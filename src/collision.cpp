@@ -0,0 +1,227 @@
+#include "collision.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace shrekrooms;
+
+
+/*
+ * struct shrekrooms::Collision
+*/
+
+Collision::Collision() :
+    isColliding(false), cancelVector({ 0.0f, 0.0f }) { }
+
+Collision::Collision(bool isColliding, glm::vec2 cancelVector) :
+    isColliding(isColliding), cancelVector(cancelVector) { }
+
+void Collision::addOtherCollision(const Collision &coll) {
+    if (!coll.isColliding)
+        return;
+    isColliding = true;
+    cancelVector += coll.cancelVector;
+}
+
+
+/*
+ * struct shrekrooms::Hitbox
+*/
+
+Hitbox::Hitbox() :
+    posMin(0.0f), posMax(0.0f) { }
+
+Hitbox::Hitbox(const glm::vec2 &posMin, const glm::vec2 &posMax) :
+    posMin(posMin), posMax(posMax) { }
+
+bool Hitbox::isInside(const glm::vec2 &pos) const {
+    return (
+        posMin.x <= pos.x && pos.x <= posMax.x &&
+        posMin.y <= pos.y && pos.y <= posMax.y
+    );
+}
+
+Collision Hitbox::getCircleIntersection(const glm::vec2 &pos, float radius) const {
+    glm::vec2 closest = glm::clamp(pos, posMin, posMax);
+    float dist = glm::distance(pos, closest);
+    if (radius < dist)
+        return { };
+    glm::vec2 dir = glm::normalize(pos - closest);
+    dir *= (radius - dist);
+    return { true, dir };
+}
+
+Hitbox shrekrooms::Hitbox::offset(const glm::vec2& offset) const {
+    return Hitbox {
+        posMin + offset,
+        posMax + offset
+    };
+}
+
+Hitbox Hitbox::merge(const Hitbox &other) const {
+    return Hitbox {
+        glm::min(posMin, other.posMin),
+        glm::max(posMax, other.posMax)
+    };
+}
+
+glm::vec2 Hitbox::getCenter() const {
+    return 0.5f * (posMin + posMax);
+}
+
+glm::vec2 Hitbox::getSize() const {
+    return posMax - posMin;
+}
+
+Hitbox Hitbox::empty() {
+    static const float inf = std::numeric_limits<float>::infinity();
+    return Hitbox {
+        {  inf,  inf },
+        { -inf, -inf }
+    };
+}
+
+
+/*
+ * class shrekrooms::HitboxBatch
+*/
+
+HitboxBatch::HitboxBatch() :
+    m_size(0), m_minX(s_laneCount - 1), m_minY(s_laneCount - 1), m_maxX(s_laneCount - 1), m_maxY(s_laneCount - 1) { }
+
+void HitboxBatch::clear() {
+    m_size = 0;
+    m_minX.assign(s_laneCount - 1, 0.0f);
+    m_minY.assign(s_laneCount - 1, 0.0f);
+    m_maxX.assign(s_laneCount - 1, 0.0f);
+    m_maxY.assign(s_laneCount - 1, 0.0f);
+}
+
+void HitboxBatch::reserve(size_t count) {
+    m_minX.reserve(count + s_laneCount - 1);
+    m_minY.reserve(count + s_laneCount - 1);
+    m_maxX.reserve(count + s_laneCount - 1);
+    m_maxY.reserve(count + s_laneCount - 1);
+}
+
+size_t HitboxBatch::push(const Hitbox &hitbox) {
+    m_minX[m_size] = hitbox.posMin.x;
+    m_minY[m_size] = hitbox.posMin.y;
+    m_maxX[m_size] = hitbox.posMax.x;
+    m_maxY[m_size] = hitbox.posMax.y;
+
+    m_minX.push_back(0.0f);
+    m_minY.push_back(0.0f);
+    m_maxX.push_back(0.0f);
+    m_maxY.push_back(0.0f);
+
+    return m_size++;
+}
+
+void HitboxBatch::set(size_t index, const Hitbox &hitbox) {
+    if (index >= m_size)
+        throw error { "collision.cpp", "shrekrooms::HitboxBatch::set", "'index' was out of range" };
+    m_minX[index] = hitbox.posMin.x;
+    m_minY[index] = hitbox.posMin.y;
+    m_maxX[index] = hitbox.posMax.x;
+    m_maxY[index] = hitbox.posMax.y;
+}
+
+size_t HitboxBatch::size() const {
+    return m_size;
+}
+
+Hitbox HitboxBatch::get(size_t index) const {
+    if (index >= m_size)
+        throw error { "collision.cpp", "shrekrooms::HitboxBatch::get", "'index' was out of range" };
+    return Hitbox {
+        { m_minX[index], m_minY[index] },
+        { m_maxX[index], m_maxY[index] }
+    };
+}
+
+void HitboxBatch::addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius, size_t begin, size_t end) const {
+    end = std::min(end, m_size);
+    if (begin >= end)
+        return;
+
+    glm::vec2 cancel { 0.0f, 0.0f };
+    bool hit = false;
+
+#if defined(__SSE2__)
+    // tailMasks[n] keeps the first n lanes
+    alignas(16) static const uint32_t tailMasks[s_laneCount + 1][s_laneCount] {
+        { 0u,  0u,  0u,  0u  },
+        { ~0u, 0u,  0u,  0u  },
+        { ~0u, ~0u, 0u,  0u  },
+        { ~0u, ~0u, ~0u, 0u  },
+        { ~0u, ~0u, ~0u, ~0u }
+    };
+
+    const __m128 px = _mm_set1_ps(pos.x);
+    const __m128 py = _mm_set1_ps(pos.y);
+    const __m128 r  = _mm_set1_ps(radius);
+    const __m128 r2 = _mm_mul_ps(r, r);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 accX = zero;
+    __m128 accY = zero;
+    int hitBits = 0;
+
+    for (size_t i = begin; i < end; i += s_laneCount) {
+        const __m128 cx = _mm_min_ps(_mm_max_ps(px, _mm_loadu_ps(&m_minX[i])), _mm_loadu_ps(&m_maxX[i]));
+        const __m128 cy = _mm_min_ps(_mm_max_ps(py, _mm_loadu_ps(&m_minY[i])), _mm_loadu_ps(&m_maxY[i]));
+        const __m128 dx = _mm_sub_ps(px, cx);
+        const __m128 dy = _mm_sub_ps(py, cy);
+        const __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        // A centre inside the rectangle has no push-out direction, skip it like a miss
+        __m128 mask = _mm_and_ps(_mm_cmple_ps(d2, r2), _mm_cmpgt_ps(d2, zero));
+        mask = _mm_and_ps(mask, _mm_load_ps(reinterpret_cast<const float *>(tailMasks[std::min(end - i, s_laneCount)])));
+
+        // Masked after the multiply so lanes holding empty or far away hitboxes cannot leak inf/NaN
+        const __m128 dist = _mm_sqrt_ps(d2);
+        const __m128 scale = _mm_div_ps(_mm_sub_ps(r, dist), dist);
+
+        accX = _mm_add_ps(accX, _mm_and_ps(mask, _mm_mul_ps(dx, scale)));
+        accY = _mm_add_ps(accY, _mm_and_ps(mask, _mm_mul_ps(dy, scale)));
+        hitBits |= _mm_movemask_ps(mask);
+    }
+
+    alignas(16) float sumX[s_laneCount], sumY[s_laneCount];
+    _mm_store_ps(sumX, accX);
+    _mm_store_ps(sumY, accY);
+    cancel = { sumX[0] + sumX[1] + sumX[2] + sumX[3], sumY[0] + sumY[1] + sumY[2] + sumY[3] };
+    hit = (hitBits != 0);
+#else
+    const float r2 = radius * radius;
+    for (size_t i = begin; i < end; i++) {
+        const glm::vec2 closest {
+            std::min(std::max(pos.x, m_minX[i]), m_maxX[i]),
+            std::min(std::max(pos.y, m_minY[i]), m_maxY[i])
+        };
+        const glm::vec2 d = pos - closest;
+        const float d2 = d.x*d.x + d.y*d.y;
+        if (d2 > r2 || d2 <= 0.0f)
+            continue;
+
+        const float dist = std::sqrt(d2);
+        cancel += d * ((radius - dist) / dist);
+        hit = true;
+    }
+#endif
+
+    coll.addOtherCollision({ hit, cancel });
+}
+
+void HitboxBatch::addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius) const {
+    addCircleIntersections(coll, pos, radius, 0, m_size);
+}
+
+void HitboxBatch::getCircleIntersections(const glm::vec2 *pos, const float *radius, size_t count, Collision *res) const {
+    for (size_t i = 0; i < count; i++) {
+        res[i] = { };
+        addCircleIntersections(res[i], pos[i], radius[i], 0, m_size);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "defines.hpp"
+
+
+namespace shrekrooms {
+
+
+struct Collision {
+    bool isColliding;
+    glm::vec2 cancelVector;
+
+    Collision();
+    Collision(bool isColliding, glm::vec2 cancelVector);
+
+    void addOtherCollision(const Collision &coll);
+
+};
+
+
+struct Hitbox {
+    glm::vec2 posMin, posMax;
+
+    Hitbox();
+    Hitbox(const glm::vec2 &posMin, const glm::vec2 &posMax);
+
+    bool isInside(const glm::vec2 &pos) const;
+
+    Collision getCircleIntersection(const glm::vec2 &pos, float radius) const;
+
+    Hitbox offset(const glm::vec2 &offset) const;
+    Hitbox merge(const Hitbox &other) const;
+
+    glm::vec2 getCenter() const;
+    glm::vec2 getSize() const;
+
+    // Never collides, merging with it is a no-op
+    static Hitbox empty();
+
+};
+
+
+/*
+ * Hitboxes stored as parallel arrays so the circle test
+ * runs on s_laneCount rectangles at once (SSE2, scalar fallback)
+*/
+class HitboxBatch {
+public:
+    static constexpr size_t s_laneCount = 4;
+
+    HitboxBatch();
+
+    void clear();
+    void reserve(size_t count);
+    size_t push(const Hitbox &hitbox);
+    void set(size_t index, const Hitbox &hitbox);
+
+    size_t size() const;
+    Hitbox get(size_t index) const;
+
+    // Tests hitboxes [begin; end)
+    void addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius, size_t begin, size_t end) const;
+    void addCircleIntersections(Collision &coll, const glm::vec2 &pos, float radius) const;
+
+    // Tests every circle against every hitbox, res has to hold count elements
+    void getCircleIntersections(const glm::vec2 *pos, const float *radius, size_t count, Collision *res) const;
+
+protected:
+    size_t m_size;
+    // Padded with (s_laneCount - 1) unused entries so the kernel can always load a full register
+    std::vector<float> m_minX, m_minY, m_maxX, m_maxY;
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "defines.hpp"
+#include "world_pos.hpp"
+
+
+namespace shrekrooms::ecs {
+
+
+using EntityID = uint32_t;
+static constexpr EntityID nullEntity = UINT32_MAX;
+
+
+struct Transform {
+    WorldPos pos;
+    float rot;              // Yaw around globalUp, 0 faces x+
+
+};
+
+
+struct Velocity {
+    glm::vec2 vel;          // Units per second on the xz plane
+
+};
+
+
+struct Collider {
+    float radius;
+    bool solid;             // Slides along walls instead of passing through them
+
+};
+
+
+// Walks the maze towards target
+struct Pursuer {
+    EntityID target;
+    WorldPos nextPos;
+    glm::ivec2 mazePos;
+    std::vector<glm::ivec2> path;   // Next cell at the back
+
+};
+
+
+// Driven by the PlayerInput with this index
+struct Controller {
+    size_t inputIndex;
+
+};
+
+
+enum class SpriteID : uint8_t {
+    Shrek
+};
+
+// Drawn as a billboard facing the viewer
+struct Sprite {
+    SpriteID id;
+
+};
+
+
+// Every component type, a component's bit is its index in this list
+using ComponentTypes = std::tuple<Transform, Velocity, Collider, Pursuer, Controller, Sprite>;
+
+
+} // namespace shrekrooms::ecs
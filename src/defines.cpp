@@ -13,27 +13,64 @@ const std::string_view shrekrooms::defines::shader::vertex   { "../shaders/verte
 const std::string_view shrekrooms::defines::shader::fragment { "../shaders/fragment.glsl" };
 
 // namespace shrekrooms::defines::world
-const float  shrekrooms::defines::world::chunkSize         = 5.0f;
-const float  shrekrooms::defines::world::chunkHeight       = 5.0f;
-const float  shrekrooms::defines::world::wallThicknessHalf = 0.5f;
-const int    shrekrooms::defines::world::chunkFloorTiles   = 2;
-const int    shrekrooms::defines::world::chunkWallTiles    = 1;
-const size_t shrekrooms::defines::world::chunksCountWidth  = 10;
-const float  shrekrooms::defines::world::bridgePercentage  = 0.2f;
+const float  shrekrooms::defines::world::chunkSize             = 5.0f;
+const float  shrekrooms::defines::world::chunkHeight           = 5.0f;
+const float  shrekrooms::defines::world::wallThicknessHalf     = 0.5f;
+const int    shrekrooms::defines::world::chunkFloorTiles       = 2;
+const int    shrekrooms::defines::world::chunkWallTiles        = 1;
+const size_t shrekrooms::defines::world::chunksCountWidth      = 10;
+const float  shrekrooms::defines::world::bridgePercentage      = 0.2f;
+const int    shrekrooms::defines::world::chunkStreamRadius     = 3;
+const int    shrekrooms::defines::world::chunkStreamHysteresis = 1;
+const bool   shrekrooms::defines::world::bakeWorldMesh         = false;
+const int    shrekrooms::defines::world::bakeRegionSize        = 4;
+const int    shrekrooms::defines::world::cullBlockSize         = 8;
+const bool   shrekrooms::defines::world::portalCulling         = true;
+const float  shrekrooms::defines::world::fogStart              = 2.0f;
+const float  shrekrooms::defines::world::fogDensity            = 0.5f;
+const float  shrekrooms::defines::world::fogCutoff             = 1.0f / 255.0f;
 
 // namespace shrekrooms::defines::player
 const float shrekrooms::defines::player::mouseSensitivity  = 7.0f;
 const float shrekrooms::defines::player::walkSpeed         = 8.0f;
 const float shrekrooms::defines::player::radius            = 0.5f;
 
+#ifndef SHREKROOMS_HEADLESS
 // namespace shrekrooms::defines::controls
-const int shrekrooms::defines::controls::keyForward  = GLFW_KEY_W;
-const int shrekrooms::defines::controls::keyBackward = GLFW_KEY_S;
-const int shrekrooms::defines::controls::keyLeft     = GLFW_KEY_A;
-const int shrekrooms::defines::controls::keyRight    = GLFW_KEY_D;
+const int shrekrooms::defines::controls::keyForward    = GLFW_KEY_W;
+const int shrekrooms::defines::controls::keyBackward   = GLFW_KEY_S;
+const int shrekrooms::defines::controls::keyLeft       = GLFW_KEY_A;
+const int shrekrooms::defines::controls::keyRight      = GLFW_KEY_D;
+const int shrekrooms::defines::controls::keyQuickSave  = GLFW_KEY_F5;
+const int shrekrooms::defines::controls::keyQuickLoad  = GLFW_KEY_F9;
+const int shrekrooms::defines::controls::keyPrintStats = GLFW_KEY_F3;
+const int shrekrooms::defines::controls::keyFogDenser  = GLFW_KEY_MINUS;
+const int shrekrooms::defines::controls::keyFogThinner = GLFW_KEY_EQUAL;
+#endif
 
 // namespace shrekrooms::defines::shrek
 const float shrekrooms::defines::shrek::width     = 3.0f;
 const float shrekrooms::defines::shrek::height    = 4.0f;
 const float shrekrooms::defines::shrek::radius    = 1.5f;
 const float shrekrooms::defines::shrek::walkSpeed = 5.0f;
+
+// namespace shrekrooms::defines::bot
+const float shrekrooms::defines::bot::turnSpeed      = 6.0f;
+const float shrekrooms::defines::bot::followDistance = 2.0f;
+const float shrekrooms::defines::bot::minHoldTime    = 0.2f;
+const float shrekrooms::defines::bot::maxHoldTime    = 1.5f;
+
+// namespace shrekrooms::defines::net
+const uint16_t shrekrooms::defines::net::defaultPort        = 27015;
+const size_t   shrekrooms::defines::net::snapshotHistory    = 64;
+const size_t   shrekrooms::defines::net::inputRedundancy    = 4;
+const size_t   shrekrooms::defines::net::maxQueuedInputs    = 8;
+const float    shrekrooms::defines::net::connectRetry       = 0.5f;
+const float    shrekrooms::defines::net::clientTimeout      = 5.0f;
+const int      shrekrooms::defines::net::relevanceRadius    = 3;
+const size_t   shrekrooms::defines::net::maxSnapshotPayload = 1200;
+
+// namespace shrekrooms::defines::simulation
+const float shrekrooms::defines::simulation::tickRate        = 60.0f;
+const int   shrekrooms::defines::simulation::maxCatchUpTicks = 5;
+const float shrekrooms::defines::simulation::contactCellSize = 3.0f;
@@ -33,6 +33,15 @@ namespace world {
     extern const int    chunkWallTiles;
     extern const size_t chunksCountWidth;
     extern const float  bridgePercentage;
+    extern const int    chunkStreamRadius;      // 0 keeps every chunk loaded
+    extern const int    chunkStreamHysteresis;
+    extern const bool   bakeWorldMesh;          // One buffer for the whole maze instead of instanced chunks
+    extern const int    bakeRegionSize;         // Chunks per side of a rebaked region
+    extern const int    cullBlockSize;          // Chunks per side of a block tested before its chunks
+    extern const bool   portalCulling;          // Skip chunks hidden behind maze walls
+    extern const float  fogStart;
+    extern const float  fogDensity;
+    extern const float  fogCutoff;              // Fog amount left to the fog colour where drawing stops
 
 } // namespace shrekrooms::defines::world
 
@@ -46,14 +55,21 @@ namespace player {
 } // namespace shrekrooms::defines::player
 
 
+#ifndef SHREKROOMS_HEADLESS
 namespace controls {
 
     extern const int keyForward;
     extern const int keyBackward;
     extern const int keyLeft;
     extern const int keyRight;
+    extern const int keyQuickSave;
+    extern const int keyQuickLoad;
+    extern const int keyPrintStats;
+    extern const int keyFogDenser;
+    extern const int keyFogThinner;
 
 } // namespace shrekrooms::defines::controls
+#endif
 
 
 namespace shrek {
@@ -66,5 +82,38 @@ namespace shrek {
 } // namespace shrekrooms::defines::shrek
 
 
+namespace bot {
+
+    extern const float turnSpeed;           // Radians per second
+    extern const float followDistance;      // Following bots stop this close to their target
+    extern const float minHoldTime;         // Seconds a random walk keeps its keys
+    extern const float maxHoldTime;
+
+} // namespace shrekrooms::defines::bot
+
+
+namespace net {
+
+    extern const uint16_t defaultPort;
+    extern const size_t   snapshotHistory;      // Snapshots kept as delta bases, in ticks
+    extern const size_t   inputRedundancy;      // Latest inputs repeated in every input packet
+    extern const size_t   maxQueuedInputs;      // Older inputs are dropped to bound the server side delay
+    extern const float    connectRetry;         // Seconds between connection attempts
+    extern const float    clientTimeout;        // Seconds of silence before a client is dropped
+    extern const int      relevanceRadius;      // Clients get the entities this many chunks around their player, as far as chunks stream
+    extern const size_t   maxSnapshotPayload;   // Snapshot bytes per datagram, larger ones are split
+
+} // namespace shrekrooms::defines::net
+
+
+namespace simulation {
+
+    extern const float tickRate;            // Ticks per second
+    extern const int   maxCatchUpTicks;     // Ticks run back to back after a stall before time is dropped
+    extern const float contactCellSize;     // Broadphase cell, at least the largest collider diameter
+
+} // namespace shrekrooms::defines::simulation
+
+
 
 }; // namespace shrekrooms::defines
@@ -0,0 +1,168 @@
+#include "ecs.hpp"
+
+using namespace shrekrooms::ecs;
+
+
+/*
+ * class shrekrooms::ecs::Archetype
+*/
+
+Archetype::Archetype(ComponentMask mask) :
+    m_mask(mask) { }
+
+ComponentMask Archetype::getMask() const {
+    return m_mask;
+}
+
+size_t Archetype::size() const {
+    return m_entities.size();
+}
+
+const EntityID *Archetype::getEntities() const {
+    return m_entities.data();
+}
+
+size_t Archetype::pushRow(EntityID id) {
+    m_entities.push_back(id);
+    m_forEachColumn([](auto &column) {
+        column.emplace_back();
+    });
+    return m_entities.size() - 1;
+}
+
+EntityID Archetype::removeRow(size_t row) {
+    const size_t last = m_entities.size() - 1;
+    m_entities[row] = m_entities[last];
+    m_entities.pop_back();
+    m_forEachColumn([row, last](auto &column) {
+        if (row != last)
+            column[row] = std::move(column[last]);
+        column.pop_back();
+    });
+    return (row != last) ? m_entities[row] : nullEntity;
+}
+
+size_t Archetype::moveRowTo(size_t row, Archetype &dst) {
+    dst.m_entities.push_back(m_entities[row]);
+    m_moveRowTo(row, dst, std::make_index_sequence<std::tuple_size_v<ComponentTypes>> { });
+    return dst.m_entities.size() - 1;
+}
+
+
+/*
+ * class shrekrooms::ecs::Registry
+*/
+
+Registry::Registry() :
+    m_size(0) { }
+
+void Registry::destroy(EntityID id) {
+    m_checkAlive(id, "shrekrooms::ecs::Registry::destroy");
+
+    Location &loc = m_locations[id];
+    const EntityID moved = m_archetypes[loc.archetype]->removeRow(loc.row);
+    if (moved != nullEntity)
+        m_locations[moved].row = loc.row;
+
+    loc.archetype = s_noArchetype;
+    m_freeIds.push_back(id);
+    m_size--;
+}
+
+bool Registry::isAlive(EntityID id) const {
+    return id < m_locations.size() && m_locations[id].archetype != s_noArchetype;
+}
+
+size_t Registry::size() const {
+    return m_size;
+}
+
+ComponentMask Registry::getMask(EntityID id) const {
+    m_checkAlive(id, "shrekrooms::ecs::Registry::getMask");
+    return m_getMask(id);
+}
+
+void Registry::clear() {
+    m_archetypes.clear();
+    m_locations.clear();
+    m_freeIds.clear();
+    m_size = 0;
+}
+
+void Registry::createAt(EntityID id, ComponentMask mask) {
+    if (isAlive(id))
+        throw error { "ecs.cpp", "shrekrooms::ecs::Registry::createAt", "Entity already exists" };
+    if (id >= m_locations.size())
+        m_locations.resize(id + 1, { s_noArchetype, 0 });
+
+    m_place(id, mask);
+}
+
+const std::vector<EntityID> &Registry::getFreeIds() const {
+    return m_freeIds;
+}
+
+void Registry::setFreeIds(std::vector<EntityID> ids) {
+    for (EntityID id : ids) {
+        if (isAlive(id))
+            throw error { "ecs.cpp", "shrekrooms::ecs::Registry::setFreeIds", "Entity is alive" };
+        if (id >= m_locations.size())
+            m_locations.resize(id + 1, { s_noArchetype, 0 });
+    }
+    m_freeIds = std::move(ids);
+}
+
+uint32_t Registry::m_getArchetype(ComponentMask mask) {
+    // Few archetypes exist, a linear search beats hashing
+    for (uint32_t i = 0; i < m_archetypes.size(); i++) {
+        if (m_archetypes[i]->getMask() == mask)
+            return i;
+    }
+    m_archetypes.push_back(std::make_unique<Archetype>(mask));
+    return static_cast<uint32_t>(m_archetypes.size() - 1);
+}
+
+ComponentMask Registry::m_getMask(EntityID id) const {
+    return m_archetypes[m_locations[id].archetype]->getMask();
+}
+
+EntityID Registry::m_allocate(ComponentMask mask) {
+    EntityID id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = static_cast<EntityID>(m_locations.size());
+        m_locations.push_back({ s_noArchetype, 0 });
+    }
+
+    m_place(id, mask);
+    return id;
+}
+
+void Registry::m_place(EntityID id, ComponentMask mask) {
+    const uint32_t archetype = m_getArchetype(mask);
+    m_locations[id] = { archetype, static_cast<uint32_t>(m_archetypes[archetype]->pushRow(id)) };
+    m_size++;
+}
+
+void Registry::m_changeMask(EntityID id, ComponentMask mask) {
+    Location &loc = m_locations[id];
+    if (m_getMask(id) == mask)
+        return;
+
+    const uint32_t dstIndex = m_getArchetype(mask);
+    Archetype &src = *m_archetypes[loc.archetype];
+    const uint32_t dstRow = static_cast<uint32_t>(src.moveRowTo(loc.row, *m_archetypes[dstIndex]));
+
+    const EntityID moved = src.removeRow(loc.row);
+    if (moved != nullEntity)
+        m_locations[moved].row = loc.row;
+
+    loc = { dstIndex, dstRow };
+}
+
+void Registry::m_checkAlive(EntityID id, const char *func) const {
+    if (!isAlive(id))
+        throw error { "ecs.cpp", func, "Entity doesn't exist" };
+}
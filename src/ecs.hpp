@@ -0,0 +1,275 @@
+#pragma once
+
+#include "defines.hpp"
+#include "components.hpp"
+
+
+namespace shrekrooms::ecs {
+
+
+using ComponentMask = uint32_t;
+
+
+template <typename _T, typename _Tuple>
+struct _TypeIndex;
+
+template <typename _T, typename... _Ts>
+struct _TypeIndex<_T, std::tuple<_T, _Ts...>> {
+    static constexpr size_t value = 0;
+};
+
+template <typename _T, typename _U, typename... _Ts>
+struct _TypeIndex<_T, std::tuple<_U, _Ts...>> {
+    static constexpr size_t value = 1 + _TypeIndex<_T, std::tuple<_Ts...>>::value;
+};
+
+template <typename _Tuple>
+struct _ColumnsOf;
+
+template <typename... _Ts>
+struct _ColumnsOf<std::tuple<_Ts...>> {
+    using type = std::tuple<std::vector<_Ts>...>;
+};
+
+
+template <typename _T>
+constexpr ComponentMask componentBit = ComponentMask { 1 } << _TypeIndex<_T, ComponentTypes>::value;
+
+template <typename... _Ts>
+constexpr ComponentMask componentMask = (ComponentMask { 0 } | ... | componentBit<_Ts>);
+
+
+/*
+ * All entities with exactly the same set of components, one array per component.
+ * Rows are kept packed, removing one moves the last row into its place
+*/
+class Archetype {
+public:
+    Archetype(ComponentMask mask);
+
+    ComponentMask getMask() const;
+    size_t size() const;
+    const EntityID *getEntities() const;
+
+    template <typename _T>
+    _T *getColumn();
+    template <typename _T>
+    const _T *getColumn() const;
+
+    // Appends default constructed components
+    size_t pushRow(EntityID id);
+    // Returns the entity now at row, nullEntity if row was the last one
+    EntityID removeRow(size_t row);
+    // Appends the row to dst, components dst lacks are dropped and the ones it adds default constructed.
+    // The row stays here until removeRow()
+    size_t moveRowTo(size_t row, Archetype &dst);
+
+protected:
+    ComponentMask m_mask;
+    std::vector<EntityID> m_entities;
+    _ColumnsOf<ComponentTypes>::type m_columns;     // Only the columns in m_mask are used
+
+    template <typename _Func>
+    void m_forEachColumn(_Func func);
+    template <size_t... _Is>
+    void m_moveRowTo(size_t row, Archetype &dst, std::index_sequence<_Is...>);
+
+};
+
+
+/*
+ * Entity store. Components live in their entity's archetype, so systems
+ * iterate plain arrays and an entity costs only its component data
+*/
+class Registry {
+public:
+    Registry();
+
+    Registry(const Registry &) = delete;
+    Registry &operator =(const Registry &) = delete;
+    Registry(Registry &&) = default;
+    Registry &operator =(Registry &&) = default;
+
+    template <typename... _Ts>
+    EntityID create(_Ts... components);
+    void destroy(EntityID id);
+
+    bool isAlive(EntityID id) const;
+    size_t size() const;
+    ComponentMask getMask(EntityID id) const;
+
+    // For restoring saved state: entities come back under their old ids, in their old storage order,
+    // and the free list decides which ids the next create() calls hand out
+    void clear();
+    void createAt(EntityID id, ComponentMask mask);
+    const std::vector<EntityID> &getFreeIds() const;
+    void setFreeIds(std::vector<EntityID> ids);
+
+    template <typename _T>
+    bool has(EntityID id) const;
+    template <typename _T>
+    _T &get(EntityID id);
+    template <typename _T>
+    const _T &get(EntityID id) const;
+
+    // Both move the entity to another archetype
+    template <typename _T>
+    void add(EntityID id, _T component);
+    template <typename _T>
+    void remove(EntityID id);
+
+    // func(count, entities, _Ts *...columns) once per archetype holding all of _Ts and none of exclude
+    template <typename... _Ts, typename _Func>
+    void eachArchetype(_Func func, ComponentMask exclude = 0);
+    template <typename... _Ts, typename _Func>
+    void eachArchetype(_Func func, ComponentMask exclude = 0) const;
+
+    // func(id, _Ts &...components) for every entity holding all of _Ts and none of exclude, in storage order
+    template <typename... _Ts, typename _Func>
+    void each(_Func func, ComponentMask exclude = 0);
+    template <typename... _Ts, typename _Func>
+    void each(_Func func, ComponentMask exclude = 0) const;
+
+protected:
+    static constexpr uint32_t s_noArchetype = UINT32_MAX;
+
+    struct Location {
+        uint32_t archetype;
+        uint32_t row;
+    };
+
+    // unique_ptr keeps archetypes in place while new ones are added
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::vector<Location> m_locations;  // By EntityID
+    std::vector<EntityID> m_freeIds;
+    size_t m_size;
+
+    uint32_t m_getArchetype(ComponentMask mask);
+    ComponentMask m_getMask(EntityID id) const;
+    EntityID m_allocate(ComponentMask mask);
+    void m_place(EntityID id, ComponentMask mask);
+    void m_changeMask(EntityID id, ComponentMask mask);
+    void m_checkAlive(EntityID id, const char *func) const;
+
+};
+
+
+/*
+ * class shrekrooms::ecs::Archetype
+*/
+
+template <typename _T>
+_T *Archetype::getColumn() {
+    return std::get<std::vector<_T>>(m_columns).data();
+}
+
+template <typename _T>
+const _T *Archetype::getColumn() const {
+    return std::get<std::vector<_T>>(m_columns).data();
+}
+
+template <typename _Func>
+void Archetype::m_forEachColumn(_Func func) {
+    std::apply([this, &func](auto &...columns) {
+        const auto visit = [this, &func](auto &column) {
+            using Component = typename std::decay_t<decltype(column)>::value_type;
+            if (m_mask & componentBit<Component>)
+                func(column);
+        };
+        (visit(columns), ...);
+    }, m_columns);
+}
+
+template <size_t... _Is>
+void Archetype::m_moveRowTo(size_t row, Archetype &dst, std::index_sequence<_Is...>) {
+    const auto moveColumn = [this, row, &dst](auto &src, auto &dstColumn) {
+        using Component = typename std::decay_t<decltype(src)>::value_type;
+        if (!(dst.m_mask & componentBit<Component>))
+            return;
+        if (m_mask & componentBit<Component>)
+            dstColumn.push_back(std::move(src[row]));
+        else
+            dstColumn.emplace_back();
+    };
+    (moveColumn(std::get<_Is>(m_columns), std::get<_Is>(dst.m_columns)), ...);
+}
+
+
+/*
+ * class shrekrooms::ecs::Registry
+*/
+
+template <typename... _Ts>
+EntityID Registry::create(_Ts... components) {
+    const EntityID id = m_allocate(componentMask<_Ts...>);
+    ((get<_Ts>(id) = std::move(components)), ...);
+    return id;
+}
+
+template <typename _T>
+bool Registry::has(EntityID id) const {
+    return isAlive(id) && (m_getMask(id) & componentBit<_T>);
+}
+
+template <typename _T>
+_T &Registry::get(EntityID id) {
+    return const_cast<_T &>(static_cast<const Registry &>(*this).get<_T>(id));
+}
+
+template <typename _T>
+const _T &Registry::get(EntityID id) const {
+    if (!has<_T>(id))
+        throw error { "ecs.hpp", "shrekrooms::ecs::Registry::get", "Entity doesn't have the component" };
+    const Location loc = m_locations[id];
+    return m_archetypes[loc.archetype]->getColumn<_T>()[loc.row];
+}
+
+template <typename _T>
+void Registry::add(EntityID id, _T component) {
+    m_checkAlive(id, "shrekrooms::ecs::Registry::add");
+    m_changeMask(id, m_getMask(id) | componentBit<_T>);
+    get<_T>(id) = std::move(component);
+}
+
+template <typename _T>
+void Registry::remove(EntityID id) {
+    m_checkAlive(id, "shrekrooms::ecs::Registry::remove");
+    m_changeMask(id, m_getMask(id) & ~componentBit<_T>);
+}
+
+template <typename... _Ts, typename _Func>
+void Registry::eachArchetype(_Func func, ComponentMask exclude) {
+    constexpr ComponentMask mask = componentMask<_Ts...>;
+    for (std::unique_ptr<Archetype> &archetype : m_archetypes) {
+        if ((archetype->getMask() & mask) == mask && !(archetype->getMask() & exclude) && archetype->size() > 0)
+            func(archetype->size(), archetype->getEntities(), archetype->getColumn<_Ts>()...);
+    }
+}
+
+template <typename... _Ts, typename _Func>
+void Registry::eachArchetype(_Func func, ComponentMask exclude) const {
+    constexpr ComponentMask mask = componentMask<_Ts...>;
+    for (const std::unique_ptr<Archetype> &archetype : m_archetypes) {
+        if ((archetype->getMask() & mask) == mask && !(archetype->getMask() & exclude) && archetype->size() > 0)
+            func(archetype->size(), archetype->getEntities(), static_cast<const Archetype &>(*archetype).getColumn<_Ts>()...);
+    }
+}
+
+template <typename... _Ts, typename _Func>
+void Registry::each(_Func func, ComponentMask exclude) {
+    eachArchetype<_Ts...>([&func](size_t count, const EntityID *entities, _Ts *...columns) {
+        for (size_t i = 0; i < count; i++)
+            func(entities[i], columns[i]...);
+    }, exclude);
+}
+
+template <typename... _Ts, typename _Func>
+void Registry::each(_Func func, ComponentMask exclude) const {
+    eachArchetype<_Ts...>([&func](size_t count, const EntityID *entities, const _Ts *...columns) {
+        for (size_t i = 0; i < count; i++)
+            func(entities[i], columns[i]...);
+    }, exclude);
+}
+
+
+} // namespace shrekrooms::ecs
@@ -0,0 +1,54 @@
+#include "frustum.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * struct shrekrooms::Frustum
+*/
+
+Frustum::Frustum() :
+        planes() { }
+
+Frustum Frustum::s_fromMatrix(const glm::mat4 &projView) {
+    // Gribb & Hartmann: a point is inside if -w <= x, y, z <= w in clip space
+    const glm::mat4 rows = glm::transpose(projView);
+
+    Frustum frustum;
+    frustum.planes = {
+        rows[3] + rows[0], rows[3] - rows[0],
+        rows[3] + rows[1], rows[3] - rows[1],
+        rows[3] + rows[2], rows[3] - rows[2]
+    };
+    for (glm::vec4 &plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+Frustum::Test Frustum::testBox(const Box &box) const {
+    Test res = Test::Inside;
+    for (const glm::vec4 &plane : planes) {
+        const glm::vec3 normal { plane };
+
+        // Corners furthest along and against the normal
+        glm::vec3 pos = box.min, neg = box.max;
+        for (int axis = 0; axis < 3; axis++) {
+            if (normal[axis] >= 0.0f)
+                std::swap(pos[axis], neg[axis]);
+        }
+
+        if (glm::dot(normal, pos) + plane.w < 0.0f)
+            return Test::Outside;
+        if (glm::dot(normal, neg) + plane.w < 0.0f)
+            res = Test::Intersecting;
+    }
+    return res;
+}
+
+bool Frustum::isSphereVisible(const glm::vec3 &center, float radius) const {
+    for (const glm::vec4 &plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
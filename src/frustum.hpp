@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.hpp"
+
+
+namespace shrekrooms {
+
+
+// Axis aligned
+struct Box {
+    glm::vec3 min, max;
+};
+
+
+/*
+ * The six planes bounding what a projection * view matrix can see,
+ * normals point inwards
+*/
+struct Frustum {
+    enum class Test {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    std::array<glm::vec4, 6> planes;
+
+    Frustum();
+
+    static Frustum s_fromMatrix(const glm::mat4 &projView);
+
+    // Conservative, boxes near a corner may be reported as intersecting while outside
+    Test testBox(const Box &box) const;
+    bool isSphereVisible(const glm::vec3 &center, float radius) const;
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,102 @@
+#include "gl_state.hpp"
+
+using namespace shrekrooms::gl;
+
+
+/*
+ * class shrekrooms::gl::StateCache
+*/
+
+StateCache::StateCache() :
+        m_program(s_unknown), m_vao(s_unknown), m_texture(s_unknown), m_stats() { }
+
+void StateCache::useProgram(GLuint program) {
+    if (program == m_program) {
+        m_stats.programSkips++;
+        return;
+    }
+    glUseProgram(program);
+    m_program = program;
+    m_stats.programBinds++;
+}
+
+void StateCache::bindVertexArray(GLuint vao) {
+    if (vao == m_vao) {
+        m_stats.vaoSkips++;
+        return;
+    }
+    glBindVertexArray(vao);
+    m_vao = vao;
+    m_stats.vaoBinds++;
+}
+
+void StateCache::bindTexture(Texture tex) {
+    if (tex == m_texture) {
+        m_stats.textureSkips++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, tex);
+    m_texture = tex;
+    m_stats.textureBinds++;
+}
+
+void StateCache::setUniform(GLint location, float value) {
+    if (m_updateUniform(location, &value, 1))
+        glUniform1f(location, value);
+}
+
+void StateCache::setUniform(GLint location, const glm::vec3 &value) {
+    if (m_updateUniform(location, glm::value_ptr(value), 3))
+        glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void StateCache::setUniform(GLint location, const glm::vec4 &value) {
+    if (m_updateUniform(location, glm::value_ptr(value), 4))
+        glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void StateCache::setUniform(GLint location, const glm::mat4 &value) {
+    if (m_updateUniform(location, glm::value_ptr(value), 16))
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void StateCache::invalidate() {
+    m_program = s_unknown;
+    m_vao = s_unknown;
+    m_texture = s_unknown;
+    m_uniforms.clear();
+}
+
+const StateCache::Stats &StateCache::getStats() const {
+    return m_stats;
+}
+
+void StateCache::resetStats() {
+    m_stats = {};
+}
+
+bool StateCache::m_updateUniform(GLint location, const float *data, size_t size) {
+    if (location < 0) {
+        m_stats.uniformSkips++;
+        return false;
+    }
+    // Without a known program there's nothing to file the value under
+    if (m_program == s_unknown) {
+        m_stats.uniformUploads++;
+        return true;
+    }
+
+    std::vector<UniformValue> &values = m_uniforms[m_program];
+    if (values.size() <= static_cast<size_t>(location))
+        values.resize(location + 1, UniformValue { {}, 0 });
+
+    UniformValue &value = values[location];
+    if (value.size == size && std::equal(data, data + size, value.data.begin())) {
+        m_stats.uniformSkips++;
+        return false;
+    }
+    std::copy(data, data + size, value.data.begin());
+    value.size = size;
+    m_stats.uniformUploads++;
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "defines.hpp"
+#include "gl_util.hpp"
+
+
+namespace shrekrooms::gl {
+
+
+/*
+ * Shadow copies of the bound program, vertex array and texture and of the
+ * uniform values of every program. Calls that wouldn't change anything are skipped.
+ * State changed without the cache, including deleting a bound object,
+ * has to be followed by invalidate()
+*/
+class StateCache {
+public:
+    struct Stats {
+        size_t programBinds, programSkips;
+        size_t vaoBinds, vaoSkips;
+        size_t textureBinds, textureSkips;
+        size_t uniformUploads, uniformSkips;
+    };
+
+    StateCache();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    // GL_TEXTURE_2D of the active unit
+    void bindTexture(Texture tex);
+
+    // For the program in use, location -1 is ignored like GL does
+    void setUniform(GLint location, float value);
+    void setUniform(GLint location, const glm::vec3 &value);
+    void setUniform(GLint location, const glm::vec4 &value);
+    void setUniform(GLint location, const glm::mat4 &value);
+
+    void invalidate();
+
+    const Stats &getStats() const;
+    void resetStats();
+
+protected:
+    static constexpr GLuint s_unknown = std::numeric_limits<GLuint>::max();
+
+    struct UniformValue {
+        std::array<float, 16> data;
+        size_t size;    // 0 if never set
+    };
+
+    GLuint m_program;
+    GLuint m_vao;
+    Texture m_texture;
+    std::unordered_map<GLuint, std::vector<UniformValue>> m_uniforms;
+    Stats m_stats;
+
+    // True if the upload is needed, the shadow then holds the new value
+    bool m_updateUniform(GLint location, const float *data, size_t size);
+
+};
+
+
+} // namespace shrekrooms::gl
@@ -6,25 +6,30 @@
 #include <stb_image.h>
 
 
-shrekrooms::gl::Texture shrekrooms::gl::loadTexture(const std::string &filename, bool interpolation) {
-    Texture tex;
-    int channels, width, height;
-    stbi_uc *data = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+shrekrooms::gl::Image shrekrooms::gl::decodeImage(const std::string &filename) {
+    Image image;
+    int channels;
+    stbi_uc *data = stbi_load(filename.c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
 
     if (!data)
-        throw error { "gl_util.cpp", "shrekrooms::gl::Texture::Texture", "Texture failed to load:\n" } << stbi_failure_reason();
+        throw error { "gl_util.cpp", "shrekrooms::gl::decodeImage", "Texture failed to load:\n" } << stbi_failure_reason();
+
+    image.pixels.assign(data, data + 4 * image.width * image.height);
+    stbi_image_free(data);
+    return image;
+}
 
+shrekrooms::gl::Texture shrekrooms::gl::uploadTexture(const Image &image, bool interpolation) {
+    Texture tex;
     glGenTextures(1, &tex);
     glBindTexture(GL_TEXTURE_2D, tex);
 
     glTexImage2D(
         GL_TEXTURE_2D,
-        0, GL_RGBA, width, height, 0,
-        GL_RGBA, GL_UNSIGNED_BYTE, data
+        0, GL_RGBA, image.width, image.height, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data()
     );
 
-    stbi_image_free(data);
-
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
@@ -33,3 +38,7 @@ shrekrooms::gl::Texture shrekrooms::gl::loadTexture(const std::string &filename,
 
     return tex;
 }
+
+shrekrooms::gl::Texture shrekrooms::gl::loadTexture(const std::string &filename, bool interpolation) {
+    return uploadTexture(decodeImage(filename), interpolation);
+}
@@ -31,8 +31,34 @@ struct Geometry {
 };
 
 
+// Per-instance offsets (vec3, attribute 2) for drawing a mesh many times in one call.
+// The vao reads vertices from the mesh's own buffer
+struct InstanceBuffer {
+    GLuint vao, vbo;
+    size_t instanceCount;
+
+    InstanceBuffer() :
+        vao(0), vbo(0), instanceCount(0) { }
+
+    ~InstanceBuffer() {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+    }
+};
+
+
 using Texture = GLuint;
 
+// RGBA8, rows top to bottom
+struct Image {
+    int width, height;
+    std::vector<unsigned char> pixels;
+};
+
+// Safe to call from any thread
+Image decodeImage(const std::string &filename); // Defined in gl_util.cpp
+// GL thread only
+Texture uploadTexture(const Image &image, bool interpolation = true); // Defined in gl_util.cpp
 Texture loadTexture(const std::string &filename, bool interpolation = true); // Defined in gl_util.cpp
 
 
@@ -12,8 +12,22 @@ void shrekrooms::gl::_m_errorCallback(int errorCode, const char *description) {
  * class shrekrooms::gl::GLContext
 */
 
-GLContext::GLContext(int width, int height, const char *title, bool windowResizeable, int exitKey) :
-        m_exitKey(exitKey) {
+GLContext::GLContext(jobs::JobSystem &jobs, int width, int height, const char *title, bool windowResizeable, int exitKey, StartupLog *startupLog) :
+        m_exitKey(exitKey), m_hasCursorPos(false), m_cursorPos(0.0, 0.0) {
+    const auto logStage = [startupLog](const std::string &name, StartupLog::Clock::time_point begin) {
+        if (startupLog)
+            startupLog->add(name, begin);
+    };
+
+    // Owned by the job as well, so an exception below can't leave it writing to a dead stack frame
+    auto images = std::make_shared<TextureManager::Images>();
+    const jobs::JobHandle decodeJob = jobs.submit([images, &jobs, logStage]() {
+        const auto begin = StartupLog::Clock::now();
+        *images = TextureManager::s_decodeImages(jobs);
+        logStage("decode textures", begin);
+    });
+
+    auto begin = StartupLog::Clock::now();
     if (!glfwInit())
         throw error { "gl.cpp", "shrekrooms::gl::GLContext::GLContext", "Failed to initialize GLFW" };
 
@@ -43,18 +57,37 @@ GLContext::GLContext(int width, int height, const char *title, bool windowResize
 
     glfwSetErrorCallback(_m_errorCallback);
 
+    glfwSetWindowUserPointer(m_window.ptr, this);
+    glfwSetKeyCallback(m_window.ptr, s_onKey);
+    glfwSetMouseButtonCallback(m_window.ptr, s_onMouseButton);
+    glfwSetCursorPosCallback(m_window.ptr, s_onCursorPos);
+    glfwSetWindowFocusCallback(m_window.ptr, s_onFocus);
+    logStage("window", begin);
+
+    begin = StartupLog::Clock::now();
     m_shader = shaders::makeShaderProgram();
+    m_state = std::make_unique<StateCache>();
+    m_uniman = std::make_unique<UniformManager>(m_shader, *m_state);
+    logStage("shaders", begin);
+
+    begin = StartupLog::Clock::now();
+    jobs.wait(decodeJob);
+    logStage("wait for textures", begin);
 
-    m_uniman = std::make_unique<UniformManager>(m_shader);
-    m_texman = std::make_unique<TextureManager>(*m_uniman);
-    m_meshman = std::make_unique<MeshManager>(*m_uniman, *m_texman);
+    begin = StartupLog::Clock::now();
+    m_texman = std::make_unique<TextureManager>(*m_uniman, *images);
+    // Uploading bound the textures directly
+    m_state->invalidate();
+    logStage("upload textures", begin);
+
+    begin = StartupLog::Clock::now();
+    m_meshman = std::make_unique<MeshManager>(*m_uniman, *m_texman, *m_state);
+    logStage("meshes", begin);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
-    enableShader();
-    glm::mat4 projMat = glm::perspective(defines::deg2rad*90.0f, m_window.getAspectRatio(), 0.1f, 15.0f);
-    m_uniman->setProjectionMatrix(projMat);
+    setFarPlane(15.0f);
     m_uniman->setTranslateMatrix(defines::mat4identity);
     m_uniman->setRotateMatrix(defines::mat4identity);
 }
@@ -85,6 +118,20 @@ const shrekrooms::MeshManager &GLContext::getMeshManager() const {
     return *m_meshman;
 }
 
+StateCache &GLContext::getStateCache() const {
+    return *m_state;
+}
+
+const glm::mat4 &GLContext::getProjectionMatrix() const {
+    return m_projection;
+}
+
+void GLContext::setFarPlane(float farPlane) {
+    m_projection = glm::perspective(defines::deg2rad*90.0f, m_window.getAspectRatio(), 0.1f, farPlane);
+    enableShader();
+    m_uniman->setProjectionMatrix(m_projection);
+}
+
 // General
 bool GLContext::isRunning() const {
     if (isKeyPressed(m_exitKey))
@@ -110,7 +157,7 @@ void GLContext::clearBackground() const {
 }
 
 void GLContext::enableShader() const {
-    glUseProgram(m_shader);
+    m_state->useProgram(m_shader);
 }
 
 void GLContext::drawBuffer() const {
@@ -135,15 +182,6 @@ bool GLContext::isMouseButtonPressed(int btn) const {
     return glfwGetMouseButton(m_window.ptr, btn) == GLFW_PRESS;
 }
 
-bool GLContext::isMouseButtonClicked(int btn) const {
-    static std::array<bool, 8> m_mouseButtonPressedPrev { false };
-
-    bool pressed = isMouseButtonPressed(btn);
-    bool res = pressed && !m_mouseButtonPressedPrev[btn];
-    m_mouseButtonPressedPrev[btn] = pressed;
-    return res;
-}
-
 bool GLContext::isMouseButtonReleased(int btn) const {
     return glfwGetMouseButton(m_window.ptr, btn) == GLFW_RELEASE;
 }
@@ -166,6 +204,44 @@ void GLContext::showCursor() const {
     glfwSetInputMode(m_window.ptr, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 }
 
+void GLContext::setCursorCaptured(bool captured) {
+    glfwSetInputMode(m_window.ptr, GLFW_CURSOR, captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    if (glfwRawMouseMotionSupported())
+        glfwSetInputMode(m_window.ptr, GLFW_RAW_MOUSE_MOTION, captured ? GLFW_TRUE : GLFW_FALSE);
+
+    // The cursor jumps when the mode changes, that is no motion
+    m_hasCursorPos = false;
+}
+
+bool GLContext::popInputEvent(InputEvent &event) {
+    return m_events.pop(event);
+}
+
+GLContext &GLContext::s_getContext(GLFWwindow *window) {
+    return *static_cast<GLContext *>(glfwGetWindowUserPointer(window));
+}
+
+void GLContext::s_onKey(GLFWwindow *window, int key, int, int action, int) {
+    s_getContext(window).m_events.push({ InputEvent::Type::Key, key, action, { 0.0f, 0.0f } });
+}
+
+void GLContext::s_onMouseButton(GLFWwindow *window, int btn, int action, int) {
+    s_getContext(window).m_events.push({ InputEvent::Type::MouseButton, btn, action, { 0.0f, 0.0f } });
+}
+
+void GLContext::s_onCursorPos(GLFWwindow *window, double x, double y) {
+    GLContext &glc = s_getContext(window);
+    const glm::dvec2 pos { x, y };
+    if (glc.m_hasCursorPos)
+        glc.m_events.push({ InputEvent::Type::MouseMotion, 0, 0, static_cast<glm::vec2>(pos - glc.m_cursorPos) });
+    glc.m_cursorPos = pos;
+    glc.m_hasCursorPos = true;
+}
+
+void GLContext::s_onFocus(GLFWwindow *window, int focused) {
+    s_getContext(window).m_events.push({ InputEvent::Type::Focus, 0, focused, { 0.0f, 0.0f } });
+}
+
 
 /*
  * struct shrekrooms::gl::GLContext::Window
@@ -4,6 +4,9 @@
 #include "shaders.hpp"
 #include "managers.hpp"
 #include "gl_util.hpp"
+#include "jobs.hpp"
+#include "spsc_queue.hpp"
+#include "startup_log.hpp"
 
 
 namespace shrekrooms::gl {
@@ -12,6 +15,22 @@ namespace shrekrooms::gl {
 void _m_errorCallback(int errorCode, const char *description);
 
 
+struct InputEvent {
+    enum class Type : uint8_t {
+        Key,
+        MouseButton,
+        MouseMotion,
+        Focus
+    };
+
+    Type type;
+    int code;           // Key or mouse button
+    int action;         // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT, for Focus whether it was gained
+    glm::vec2 delta;    // Mouse motion in screen pixels
+
+};
+
+
 class GLContext {
 public:
     struct Window {
@@ -25,7 +44,9 @@ public:
     };
 
 
-    GLContext(int width, int height, const char *title, bool windowResizeable = false, int exitKey = GLFW_KEY_UNKNOWN);
+    // Textures are decoded on the job system while the window and shaders are set up.
+    // The stages are added to startupLog if given
+    GLContext(jobs::JobSystem &jobs, int width, int height, const char *title, bool windowResizeable = false, int exitKey = GLFW_KEY_UNKNOWN, StartupLog *startupLog = nullptr);
     ~GLContext();
 
     // Getters/setters
@@ -34,6 +55,9 @@ public:
     const UniformManager &getUniformManager() const;
     const TextureManager &getTextureManager() const;
     const MeshManager &getMeshManager() const;
+    StateCache &getStateCache() const;
+    const glm::mat4 &getProjectionMatrix() const;
+    void setFarPlane(float farPlane);
 
     // General
     bool isRunning() const;
@@ -53,21 +77,40 @@ public:
     
     // Mouse
     bool isMouseButtonPressed(int btn) const;
-    bool isMouseButtonClicked(int btn) const;
     bool isMouseButtonReleased(int btn) const;
     glm::vec2 getCursorPos() const;
     void setCursorPos(glm::vec2 pos) const;
     void hideCursor() const;
     void showCursor() const;
+    // Hides and locks the cursor, motion is then reported raw (unaccelerated) where supported
+    void setCursorCaptured(bool captured);
+
+    // Events from the GLFW callbacks in the order they happened, filled by pollEvents()
+    bool popInputEvent(InputEvent &event);
 
 protected:
+    // A full queue drops events, it holds many frames worth of input
+    using M_EventQueue = SpscQueue<InputEvent, 1024>;
+
     GLuint m_shader;
     Window m_window;
+    std::unique_ptr<StateCache> m_state;
     std::unique_ptr<UniformManager> m_uniman;
     std::unique_ptr<TextureManager> m_texman;
     std::unique_ptr<MeshManager> m_meshman;
+    glm::mat4 m_projection;
     int m_exitKey;
 
+    M_EventQueue m_events;
+    bool m_hasCursorPos;
+    glm::dvec2 m_cursorPos;
+
+    static GLContext &s_getContext(GLFWwindow *window);
+    static void s_onKey(GLFWwindow *window, int key, int scancode, int action, int mods);
+    static void s_onMouseButton(GLFWwindow *window, int btn, int action, int mods);
+    static void s_onCursorPos(GLFWwindow *window, double x, double y);
+    static void s_onFocus(GLFWwindow *window, int focused);
+
 };
 
 
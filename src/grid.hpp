@@ -58,7 +58,7 @@ public:
     }
 
     size_t height() const {
-        return m_width;
+        return m_height;
     }
 
     // Iterators
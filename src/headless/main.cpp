@@ -0,0 +1,385 @@
+#include "simulation.hpp"
+#include "save_state.hpp"
+#include "bot.hpp"
+#include "server.hpp"
+#include "client.hpp"
+
+
+/*
+ * Runs the simulation without a window, as fast as it goes.
+ * The options are listed in printUsage() below
+*/
+
+
+namespace {
+
+
+void printUsage() {
+    std::cerr << "Usage: ShrekroomsHeadless [options]\n"
+        "  --replay <file>  replays an input log and checks its final state hash\n"
+        "  --ticks <n>      ticks to run without input (default: one minute of game time)\n"
+        "  --seed <seed>    world seed for --ticks\n"
+        "  --load <file>    starts --ticks from a saved state instead of a new world\n"
+        "  --save <file>    saves the state reached at the end\n"
+        "  --bots <n>       plays --ticks with n bots instead of an idle player\n"
+        "  --serve [port]   hosts the world of --seed over loopback UDP for --ticks, in real time\n"
+        "  --connect [port] joins with --bots load clients (default 1) for --ticks, in real time\n"
+        "                   (port defaults to " << shrekrooms::defines::net::defaultPort << ")\n";
+}
+
+
+struct RunResult {
+    size_t ticks;
+    float seconds;
+    uint64_t hash;
+    std::vector<float> tickSeconds;
+
+};
+
+
+// A world and the simulation running in it
+struct Session {
+    std::unique_ptr<shrekrooms::rng::Random> random;
+    std::unique_ptr<shrekrooms::maze::Maze> maze;
+    std::unique_ptr<shrekrooms::World> world;
+    std::unique_ptr<shrekrooms::Simulation> sim;
+
+};
+
+
+// The whole string has to be a number no larger than max
+bool parseNumber(const char *str, uint64_t max, uint64_t &res) {
+    if (str[0] < '0' || str[0] > '9')
+        return false;
+    try {
+        size_t end;
+        res = std::stoull(str, &end);
+        return str[end] == '\0' && res <= max;
+    } catch (const std::logic_error &) {
+        return false;
+    }
+}
+
+// Without a simulation
+Session newWorld(shrekrooms::jobs::JobSystem &jobs, shrekrooms::rng::Random::Seed seed) {
+    using namespace shrekrooms;
+
+    Session session;
+    session.random = std::make_unique<rng::Random>(seed);
+    session.maze = std::make_unique<maze::Maze>(*session.random, defines::world::chunksCountWidth, defines::world::bridgePercentage);
+    session.world = std::make_unique<World>(*session.maze, jobs);
+    return session;
+}
+
+// Player 0 starts at the origin, any others in random cells
+Session newSession(shrekrooms::jobs::JobSystem &jobs, shrekrooms::rng::Random::Seed seed, size_t playerCount) {
+    using namespace shrekrooms;
+
+    Session session = newWorld(jobs, seed);
+    session.sim = std::make_unique<Simulation>(*session.world, jobs);
+
+    ecs::Registry &registry = session.sim->getRegistry();
+    const ecs::EntityID playerId = spawnPlayer(registry, { }, 0.0f, 0);
+    spawnShrek(registry, *session.maze, { 5, 5 }, playerId);
+
+    rng::RandInt randCell = session.random->getRandInt(0, static_cast<int>(session.maze->getSize()) - 1);
+    for (size_t i = 1; i < playerCount; i++) {
+        const int x = randCell.get();
+        spawnPlayer(registry, { { x, randCell.get() }, { 0.0f, 0.0f, 0.0f } }, 0.0f, i);
+    }
+    return session;
+}
+
+// One bot for every Controller, the policies take turns by input index and followers follow player 0
+std::vector<shrekrooms::Bot> makeBots(const shrekrooms::ecs::Registry &registry, shrekrooms::rng::Random::Seed seed) {
+    using namespace shrekrooms;
+
+    ecs::EntityID leader = ecs::nullEntity;
+    std::vector<std::pair<size_t, ecs::EntityID>> players;
+    registry.each<ecs::Controller>([&](ecs::EntityID id, const ecs::Controller &controller) {
+        players.emplace_back(controller.inputIndex, id);
+        if (controller.inputIndex == 0)
+            leader = id;
+    });
+    std::sort(players.begin(), players.end());
+
+    static constexpr std::array<BotPolicy, 3> policies { BotPolicy::Wander, BotPolicy::Follow, BotPolicy::RandomWalk };
+
+    std::vector<Bot> bots;
+    for (const auto &[inputIndex, id] : players) {
+        BotPolicy policy = policies[inputIndex % policies.size()];
+        if (policy == BotPolicy::Follow && (leader == ecs::nullEntity || leader == id))
+            policy = BotPolicy::Wander;
+        bots.emplace_back(id, policy, seed + static_cast<rng::Random::Seed>(inputIndex), leader);
+    }
+    return bots;
+}
+
+Session loadSession(shrekrooms::jobs::JobSystem &jobs, const std::vector<uint8_t> &blob) {
+    using namespace shrekrooms;
+
+    Session session;
+    session.maze = save::readMaze(blob);
+    session.world = std::make_unique<World>(*session.maze, jobs);
+    session.sim = std::make_unique<Simulation>(*session.world, jobs);
+    save::readState(blob, *session.sim);
+    return session;
+}
+
+template <typename _InputFunc>
+RunResult run(Session &session, size_t ticks, _InputFunc getInput) {
+    using namespace shrekrooms;
+
+    RunResult res { ticks, 0.0f, 0, { } };
+    res.tickSeconds.reserve(ticks);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    auto tickStart = startTime;
+    for (size_t tick = 0; tick < ticks; tick++) {
+        session.sim->tick(getInput(tick));
+
+        const auto tickEnd = std::chrono::steady_clock::now();
+        res.tickSeconds.push_back(std::chrono::duration_cast<DurationSecondsFloat>(tickEnd - tickStart).count());
+        tickStart = tickEnd;
+    }
+    res.seconds = std::chrono::duration_cast<DurationSecondsFloat>(tickStart - startTime).count();
+    res.hash = session.sim->getStateHash();
+    return res;
+}
+
+// Calls tickFunc at the simulation's tick rate and report once per second
+template <typename _TickFunc, typename _ReportFunc>
+void runRealTime(size_t ticks, _TickFunc tickFunc, _ReportFunc report) {
+    using Clock = std::chrono::steady_clock;
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(shrekrooms::DurationSecondsFloat { shrekrooms::Simulation::s_getTickDuration() });
+    const size_t reportTicks = static_cast<size_t>(shrekrooms::defines::simulation::tickRate);
+
+    auto nextTick = Clock::now();
+    for (size_t tick = 0; tick < ticks; tick++) {
+        tickFunc();
+        if ((tick + 1) % reportTicks == 0)
+            report();
+
+        nextTick += tickDuration;
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void serve(shrekrooms::jobs::JobSystem &jobs, shrekrooms::rng::Random::Seed seed, uint16_t port, size_t ticks) {
+    using namespace shrekrooms;
+
+    Session session = newSession(jobs, seed, 1);
+    net::Server server { *session.sim, seed, port };
+    std::cout << "Serving seed " << seed << " on port " << server.getPort() << '\n';
+
+    runRealTime(ticks, [&server]() { server.tick(); }, [&server]() {
+        const net::Server::Stats &stats = server.getStats();
+        const float ticks = static_cast<float>(std::max<size_t>(stats.ticks, 1));
+        const float clientSeconds = static_cast<float>(stats.clientTicks) / defines::simulation::tickRate;
+
+        std::cout << server.getClientCount() << " clients, tick avg " << 1e3f * stats.tickSeconds / ticks
+                  << " ms, max " << 1e3f * stats.maxTickSeconds << " ms";
+        if (clientSeconds > 0.0f) {
+            std::cout << ", per client " << 1e-3f * static_cast<float>(stats.bytesSent) / clientSeconds << " kB/s down, "
+                      << 1e-3f * static_cast<float>(stats.bytesReceived) / clientSeconds << " kB/s up";
+        }
+        std::cout << ", " << stats.fullSnapshots << " full snapshots, " << stats.failedSends << " failed sends\n";
+        server.resetStats();
+    });
+}
+
+void connect(shrekrooms::jobs::JobSystem &jobs, shrekrooms::rng::Random::Seed seed, uint16_t port, size_t clientCount, size_t ticks) {
+    using namespace shrekrooms;
+
+    // Every client predicts in the same world
+    const Session session = newWorld(jobs, seed);
+    const float dt = Simulation::s_getTickDuration();
+
+    std::vector<std::unique_ptr<net::Client>> clients;
+    std::vector<std::optional<Bot>> bots { clientCount };
+    for (size_t i = 0; i < clientCount; i++)
+        clients.push_back(std::make_unique<net::Client>(*session.world, seed, jobs, port));
+
+    runRealTime(ticks, [&]() {
+        for (size_t i = 0; i < clientCount; i++) {
+            net::Client &client = *clients[i];
+            // Following needs the other players, which only exist in the server's snapshots
+            if (!bots[i] && client.hasState())
+                bots[i].emplace(client.getPredictedEntity(), (i % 2) ? BotPolicy::RandomWalk : BotPolicy::Wander, seed + static_cast<rng::Random::Seed>(i));
+
+            client.tick(bots[i] ? bots[i]->think(client.getPrediction().getRegistry(), *session.world, dt) : PlayerInput {});
+        }
+    }, [&]() {
+        size_t connected = 0;
+        net::Client::Stats total {};
+        for (const auto &client : clients) {
+            const net::Client::Stats &stats = client->getStats();
+            connected += client->isConnected();
+            total.snapshots += stats.snapshots;
+            total.bytesSent += stats.bytesSent;
+            total.bytesReceived += stats.bytesReceived;
+            total.corrections += stats.corrections;
+            total.correctionSum += stats.correctionSum;
+            total.maxCorrection = std::max(total.maxCorrection, stats.maxCorrection);
+            client->resetStats();
+        }
+
+        const float perClient = 1e-3f / static_cast<float>(std::max<size_t>(clientCount, 1));
+        std::cout << connected << '/' << clientCount << " connected, per client " << perClient * static_cast<float>(total.bytesReceived) << " kB/s down, "
+                  << perClient * static_cast<float>(total.bytesSent) << " kB/s up, " << total.snapshots << " snapshots, "
+                  << total.corrections << " corrections (avg " << total.correctionSum / static_cast<float>(std::max<size_t>(total.corrections, 1))
+                  << ", max " << total.maxCorrection << ")\n";
+    });
+}
+
+void printResult(const RunResult &res, const shrekrooms::jobs::JobSystem &jobs) {
+    std::cout << res.ticks << " ticks in " << res.seconds << " s ("
+              << static_cast<float>(res.ticks) / std::max(res.seconds, std::numeric_limits<float>::min()) << " ticks/s)\n"
+              << "State hash " << std::hex << res.hash << std::dec << '\n';
+
+    if (!res.tickSeconds.empty()) {
+        std::vector<float> sorted = res.tickSeconds;
+        std::sort(sorted.begin(), sorted.end());
+        const auto percentile = [&sorted](float p) {
+            return 1e6f * sorted[static_cast<size_t>(p * static_cast<float>(sorted.size() - 1))];
+        };
+        std::cout << "Tick us: p50 " << percentile(0.5f) << ", p90 " << percentile(0.9f)
+                  << ", p99 " << percentile(0.99f) << ", max " << percentile(1.0f) << '\n';
+    }
+
+    const std::vector<shrekrooms::jobs::JobSystem::WorkerStats> stats = jobs.getStats();
+    for (size_t i = 0; i < stats.size(); i++) {
+        std::cout << "Worker " << i << ": " << stats[i].jobsRun << " jobs (" << stats[i].jobsStolen << " stolen), "
+                  << 100.0f * stats[i].getUtilisation() << "% busy\n";
+    }
+}
+
+
+} // namespace
+
+
+int main(int argc, const char **argv) {
+    using namespace shrekrooms;
+
+    std::string replayPath, loadPath, savePath;
+    int servePort = -1, connectPort = -1;
+    size_t ticks = static_cast<size_t>(60.0f * defines::simulation::tickRate);
+    rng::Random::Seed seed = 0;
+    size_t botCount = 0;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            const std::string_view arg = argv[i];
+            uint64_t number;
+            bool isValid = true;
+
+            // The port of --serve and --connect is optional
+            if (arg == "--serve" || arg == "--connect") {
+                number = defines::net::defaultPort;
+                if (i+1 < argc && argv[i+1][0] != '-')
+                    isValid = parseNumber(argv[++i], UINT16_MAX, number);
+                (arg == "--serve" ? servePort : connectPort) = static_cast<int>(number);
+            }
+            else if (arg != "--replay" && arg != "--ticks" && arg != "--seed" && arg != "--load" && arg != "--save" && arg != "--bots") {
+                std::cerr << "Unknown option " << arg << '\n';
+                printUsage();
+                return 1;
+            }
+            else if (i+1 == argc) {
+                std::cerr << arg << " needs a value\n";
+                printUsage();
+                return 1;
+            }
+            else if (arg == "--replay")
+                replayPath = argv[++i];
+            else if (arg == "--load")
+                loadPath = argv[++i];
+            else if (arg == "--save")
+                savePath = argv[++i];
+            else if (arg == "--ticks") {
+                isValid = parseNumber(argv[++i], SIZE_MAX, number);
+                ticks = number;
+            }
+            else if (arg == "--seed") {
+                isValid = parseNumber(argv[++i], std::numeric_limits<rng::Random::Seed>::max(), number);
+                seed = static_cast<rng::Random::Seed>(number);
+            }
+            else if (arg == "--bots") {
+                isValid = parseNumber(argv[++i], SIZE_MAX, number);
+                botCount = number;
+            }
+
+            if (!isValid) {
+                std::cerr << "Invalid value '" << argv[i] << "' for " << arg << '\n';
+                printUsage();
+                return 1;
+            }
+        }
+
+        jobs::JobSystem jobs;
+
+        if (servePort >= 0) {
+            serve(jobs, seed, static_cast<uint16_t>(servePort), ticks);
+            return 0;
+        }
+        if (connectPort >= 0) {
+            connect(jobs, seed, static_cast<uint16_t>(connectPort), std::max<size_t>(botCount, 1), ticks);
+            return 0;
+        }
+
+        Session session;
+        RunResult res;
+        bool matches = true;
+
+        if (replayPath.empty()) {
+            session = loadPath.empty() ? newSession(jobs, seed, std::max<size_t>(botCount, 1)) : loadSession(jobs, save::readFile(loadPath));
+
+            if (botCount == 0) {
+                res = run(session, ticks, [](size_t) { return PlayerInput {}; });
+            } else {
+                std::vector<Bot> bots = makeBots(session.sim->getRegistry(), seed);
+                std::vector<PlayerInput> inputs;
+                const float dt = Simulation::s_getTickDuration();
+                res = run(session, ticks, [&](size_t) -> const std::vector<PlayerInput> & {
+                    updateBots(bots, session.sim->getRegistry(), *session.world, jobs, dt, inputs);
+                    return inputs;
+                });
+                std::cout << bots.size() << " bots\n";
+            }
+            printResult(res, jobs);
+        } else {
+            const InputLog log = InputLog::load(replayPath);
+            if (log.getTickRate() != defines::simulation::tickRate) {
+                std::cerr << "'" << replayPath << "' was recorded at " << log.getTickRate() << " ticks/s, expected " << defines::simulation::tickRate << '\n';
+                return 1;
+            }
+
+            session = newSession(jobs, log.getSeed(), 1);
+            res = run(session, log.getTickCount(), [&log](size_t tick) { return log.getTick(tick); });
+            printResult(res, jobs);
+
+            matches = (res.hash == log.getFinalHash());
+            if (matches)
+                std::cout << "Matches the recording\n";
+            else
+                std::cout << "Mismatch, recorded " << std::hex << log.getFinalHash() << std::dec << '\n';
+        }
+
+        if (!savePath.empty()) {
+            std::vector<uint8_t> blob;
+            const auto startTime = std::chrono::steady_clock::now();
+            save::writeState(*session.sim, blob);
+            const float seconds = std::chrono::duration_cast<DurationSecondsFloat>(std::chrono::steady_clock::now() - startTime).count();
+            save::writeFile(savePath, blob);
+            std::cout << "Saved " << blob.size() << " bytes in " << 1e6f * seconds << " us\n";
+        }
+
+        if (!matches)
+            return 1;
+    } catch (const std::exception &err) {
+        std::cerr << err.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
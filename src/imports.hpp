@@ -1,10 +1,12 @@
 #pragma once
 
 /*
- * Opengl v4.6
+ * Opengl v4.6, left out of the headless build
 */
+#ifndef SHREKROOMS_HEADLESS
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#endif
 
 /*
  * glm
@@ -21,16 +23,26 @@
 // #include <sstream>
 
 #include <stdexcept>
+#include <cstring>
 
 #include <memory>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <array>
+#include <optional>
 // #include <map>
+#include <unordered_map>
 #include <stack>
+#include <deque>
+#include <functional>
 #include <random>
 
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 
 namespace shrekrooms {
@@ -0,0 +1,76 @@
+#include "input.hpp"
+
+using namespace shrekrooms::gl;
+
+
+/*
+ * class shrekrooms::gl::InputState
+*/
+
+InputState::InputState() :
+        m_isFocused(true), m_mouseDelta(0.0f, 0.0f) {
+    m_keysDown.fill(false);
+    m_keysPressed.fill(false);
+    m_buttonsClicked.fill(false);
+}
+
+void InputState::update(GLContext &glc) {
+    InputEvent event;
+    while (glc.popInputEvent(event))
+        apply(event);
+}
+
+void InputState::apply(const InputEvent &event) {
+    switch (event.type) {
+        case InputEvent::Type::Key:
+            // GLFW_KEY_UNKNOWN is -1
+            if (event.code < 0 || event.code > GLFW_KEY_LAST)
+                break;
+            m_keysDown[event.code] = (event.action != GLFW_RELEASE);
+            if (event.action == GLFW_PRESS)
+                m_keysPressed[event.code] = true;
+            break;
+        case InputEvent::Type::MouseButton:
+            if (event.code < 0 || event.code > GLFW_MOUSE_BUTTON_LAST)
+                break;
+            if (event.action == GLFW_PRESS)
+                m_buttonsClicked[event.code] = true;
+            break;
+        case InputEvent::Type::MouseMotion:
+            m_mouseDelta += event.delta;
+            break;
+        case InputEvent::Type::Focus:
+            // Releases aren't reported to unfocused windows
+            m_isFocused = event.action;
+            if (!m_isFocused)
+                m_keysDown.fill(false);
+            break;
+    }
+}
+
+void InputState::clearEdges() {
+    m_keysPressed.fill(false);
+    m_buttonsClicked.fill(false);
+}
+
+bool InputState::isFocused() const {
+    return m_isFocused;
+}
+
+bool InputState::isKeyDown(int key) const {
+    return key >= 0 && key <= GLFW_KEY_LAST && m_keysDown[key];
+}
+
+bool InputState::wasKeyPressed(int key) const {
+    return key >= 0 && key <= GLFW_KEY_LAST && m_keysPressed[key];
+}
+
+bool InputState::wasMouseButtonClicked(int btn) const {
+    return btn >= 0 && btn <= GLFW_MOUSE_BUTTON_LAST && m_buttonsClicked[btn];
+}
+
+glm::vec2 InputState::takeMouseDelta() {
+    const glm::vec2 delta = m_mouseDelta;
+    m_mouseDelta = { 0.0f, 0.0f };
+    return delta;
+}
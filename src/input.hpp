@@ -0,0 +1,43 @@
+#pragma once
+
+#include "defines.hpp"
+#include "glc.hpp"
+
+
+namespace shrekrooms::gl {
+
+
+/*
+ * Keyboard and mouse state built from the GLContext's input events,
+ * so nothing has to be polled from GLFW per key and frame
+*/
+class InputState {
+public:
+    InputState();
+
+    // Applies every event waiting in glc
+    void update(GLContext &glc);
+    void apply(const InputEvent &event);
+    // Forgets the presses and clicks seen so far
+    void clearEdges();
+
+    bool isFocused() const;
+    bool isKeyDown(int key) const;
+    // Since the last clearEdges(), key repeats don't count
+    bool wasKeyPressed(int key) const;
+    bool wasMouseButtonClicked(int btn) const;
+
+    // Motion since the last call
+    glm::vec2 takeMouseDelta();
+
+protected:
+    bool m_isFocused;
+    std::array<bool, GLFW_KEY_LAST + 1> m_keysDown;
+    std::array<bool, GLFW_KEY_LAST + 1> m_keysPressed;
+    std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> m_buttonsClicked;
+    glm::vec2 m_mouseDelta;
+
+};
+
+
+} // namespace shrekrooms::gl
@@ -0,0 +1,120 @@
+#include "input_log.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * class shrekrooms::InputLog
+*/
+
+InputLog::InputLog() :
+    InputLog(0) { }
+
+InputLog::InputLog(rng::Random::Seed seed) :
+    m_seed(seed), m_tickRate(defines::simulation::tickRate), m_finalHash(0) { }
+
+rng::Random::Seed InputLog::getSeed() const {
+    return m_seed;
+}
+
+float InputLog::getTickRate() const {
+    return m_tickRate;
+}
+
+size_t InputLog::getTickCount() const {
+    return m_ticks.size();
+}
+
+const PlayerInput &InputLog::getTick(size_t tick) const {
+    if (tick >= m_ticks.size())
+        throw error { "input_log.cpp", "shrekrooms::InputLog::getTick", "Tick out of range" };
+    return m_ticks[tick];
+}
+
+uint64_t InputLog::getFinalHash() const {
+    return m_finalHash;
+}
+
+void InputLog::push(const PlayerInput &input) {
+    m_ticks.push_back(input);
+}
+
+void InputLog::setFinalHash(uint64_t hash) {
+    m_finalHash = hash;
+}
+
+void InputLog::save(const std::string &path) const {
+    std::ofstream file { path, std::ios::binary };
+    if (!file)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::save", "Failed to open '" + path + "'" };
+
+    s_write<uint32_t>(file, s_magic);
+    s_write<uint32_t>(file, s_version);
+    s_write<uint32_t>(file, m_seed);
+    s_write<float>(file, m_tickRate);
+    s_write<uint64_t>(file, m_ticks.size());
+
+    for (const PlayerInput &input : m_ticks) {
+        uint8_t keys = 0;
+        if (input.forward)  keys |= KeyBit::Forward;
+        if (input.backward) keys |= KeyBit::Backward;
+        if (input.left)     keys |= KeyBit::Left;
+        if (input.right)    keys |= KeyBit::Right;
+        s_write<uint8_t>(file, keys);
+        s_write<float>(file, input.mouseDeltaX);
+    }
+
+    s_write<uint64_t>(file, m_finalHash);
+
+    if (!file)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::save", "Failed to write '" + path + "'" };
+}
+
+InputLog InputLog::load(const std::string &path) {
+    std::ifstream file { path, std::ios::binary };
+    if (!file)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::load", "Failed to open '" + path + "'" };
+
+    if (s_read<uint32_t>(file, path) != s_magic)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::load", "'" + path + "' is not an input log" };
+    if (s_read<uint32_t>(file, path) != s_version)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::load", "'" + path + "' has an unsupported version" };
+
+    InputLog log { s_read<uint32_t>(file, path) };
+    log.m_tickRate = s_read<float>(file, path);
+
+    // Checked against what is left of the file before allocating for it
+    static constexpr uint64_t tickSize = sizeof(uint8_t) + sizeof(float);
+    const uint64_t tickCount = s_read<uint64_t>(file, path);
+    const std::streampos ticksBegin = file.tellg();
+    file.seekg(0, std::ios::end);
+    const uint64_t remaining = static_cast<uint64_t>(file.tellg() - ticksBegin);
+    file.seekg(ticksBegin);
+    if (remaining < sizeof(uint64_t) || tickCount > (remaining - sizeof(uint64_t)) / tickSize)
+        throw error { "input_log.cpp", "shrekrooms::InputLog::load", "'" + path + "' has more ticks than data" };
+    log.m_ticks.resize(tickCount);
+    for (PlayerInput &input : log.m_ticks) {
+        const uint8_t keys = s_read<uint8_t>(file, path);
+        input.forward  = keys & KeyBit::Forward;
+        input.backward = keys & KeyBit::Backward;
+        input.left     = keys & KeyBit::Left;
+        input.right    = keys & KeyBit::Right;
+        input.mouseDeltaX = s_read<float>(file, path);
+    }
+
+    log.m_finalHash = s_read<uint64_t>(file, path);
+    return log;
+}
+
+template <typename _T>
+void InputLog::s_write(std::ofstream &file, const _T &val) {
+    file.write(reinterpret_cast<const char *>(&val), sizeof(_T));
+}
+
+template <typename _T>
+_T InputLog::s_read(std::ifstream &file, const std::string &path) {
+    _T val;
+    if (!file.read(reinterpret_cast<char *>(&val), sizeof(_T)))
+        throw error { "input_log.cpp", "shrekrooms::InputLog::load", "'" + path + "' is truncated" };
+    return val;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "defines.hpp"
+#include "rng.hpp"
+#include "player.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Everything needed to reproduce a run: the world seed and the input consumed by every tick.
+ * Stored as a little endian binary file, 5 bytes per tick
+*/
+class InputLog {
+public:
+    InputLog();
+    InputLog(rng::Random::Seed seed);
+
+    rng::Random::Seed getSeed() const;
+    float getTickRate() const;
+    size_t getTickCount() const;
+    const PlayerInput &getTick(size_t tick) const;
+    uint64_t getFinalHash() const;
+
+    void push(const PlayerInput &input);
+    void setFinalHash(uint64_t hash);
+
+    void save(const std::string &path) const;
+    static InputLog load(const std::string &path);
+
+protected:
+    static constexpr uint32_t s_magic = 0x4c495253;     // "SRIL"
+    static constexpr uint32_t s_version = 1;
+
+    enum KeyBit : uint8_t {
+        Forward  = 1 << 0,
+        Backward = 1 << 1,
+        Left     = 1 << 2,
+        Right    = 1 << 3
+    };
+
+    rng::Random::Seed m_seed;
+    float m_tickRate;
+    std::vector<PlayerInput> m_ticks;
+    uint64_t m_finalHash;
+
+    template <typename _T>
+    static void s_write(std::ofstream &file, const _T &val);
+    template <typename _T>
+    static _T s_read(std::ifstream &file, const std::string &path);
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,299 @@
+#include "jobs.hpp"
+
+using namespace shrekrooms::jobs;
+
+
+struct JobHandle::Job {
+    JobSystem::JobFunc func;
+    std::atomic<size_t> pendingDependencies;
+
+    std::exception_ptr error;                       // Rethrown by JobSystem::wait(), also set when a dependency failed
+
+    std::mutex mutex;
+    bool done;                                      // Guarded by mutex
+    std::vector<std::shared_ptr<Job>> dependents;   // Guarded by mutex
+
+};
+
+
+/*
+ * class shrekrooms::jobs::JobHandle
+*/
+
+JobHandle::JobHandle() :
+    m_job() { }
+
+JobHandle::JobHandle(std::shared_ptr<Job> job) :
+    m_job(std::move(job)) { }
+
+bool JobHandle::isValid() const {
+    return static_cast<bool>(m_job);
+}
+
+bool JobHandle::isDone() const {
+    if (!m_job)
+        return true;
+    std::lock_guard<std::mutex> lock { m_job->mutex };
+    return m_job->done;
+}
+
+
+/*
+ * class shrekrooms::jobs::JobSystem
+*/
+
+thread_local JobSystem *JobSystem::t_system = nullptr;
+thread_local size_t JobSystem::t_workerIndex = SIZE_MAX;
+thread_local size_t JobSystem::t_jobDepth = 0;
+thread_local uint64_t JobSystem::t_waitNanos = 0;
+
+float JobSystem::WorkerStats::getUtilisation() const {
+    const float total = busySeconds + idleSeconds;
+    return (total > 0.0f) ? busySeconds / total : 0.0f;
+}
+
+JobSystem::JobSystem(size_t workerCount) :
+        m_running(true), m_nextWorker(0), m_queuedCount(0) {
+    if (workerCount == 0)
+        workerCount = std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++)
+        m_workers.push_back(std::make_unique<Worker>());
+    resetStats();
+
+    m_threads.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++)
+        m_threads.emplace_back(&JobSystem::m_workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock { m_sleepMutex };
+        m_running = false;
+    }
+    m_sleepCondition.notify_all();
+
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+size_t JobSystem::getWorkerCount() const {
+    return m_workers.size();
+}
+
+JobHandle JobSystem::submit(JobFunc func, const std::vector<JobHandle> &dependencies) {
+    JobPtr job = std::make_shared<JobHandle::Job>();
+    job->func = std::move(func);
+    job->done = false;
+    // Held until every dependency is registered, so none of them can release the job early
+    job->pendingDependencies = 1;
+
+    for (const JobHandle &dep : dependencies) {
+        if (!dep.m_job)
+            continue;
+        std::lock_guard<std::mutex> lock { dep.m_job->mutex };
+        if (dep.m_job->done) {
+            if (dep.m_job->error && !job->error)
+                job->error = dep.m_job->error;
+            continue;
+        }
+        job->pendingDependencies++;
+        dep.m_job->dependents.push_back(job);
+    }
+
+    m_release(job);
+    return { job };
+}
+
+void JobSystem::wait(const JobHandle &handle) {
+    const bool isWorker = (t_system == this);
+
+    while (!handle.isDone()) {
+        if (m_runOne())
+            continue;
+
+        const auto startTime = std::chrono::steady_clock::now();
+        std::this_thread::yield();
+        if (isWorker) {
+            const uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+            m_workers[t_workerIndex]->idleNanos += nanos;
+            t_waitNanos += nanos;
+        }
+    }
+
+    if (handle.m_job && handle.m_job->error)
+        std::rethrow_exception(handle.m_job->error);
+}
+
+void JobSystem::wait(const std::vector<JobHandle> &handles) {
+    // Every job has to finish before rethrowing, they may reference the caller's stack
+    std::exception_ptr error;
+    for (const JobHandle &handle : handles) {
+        try {
+            wait(handle);
+        } catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::getStats() const {
+    std::vector<WorkerStats> res;
+    res.reserve(m_workers.size());
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        res.push_back({
+            worker->jobsRun,
+            worker->jobsStolen,
+            1e-9f * static_cast<float>(worker->busyNanos),
+            1e-9f * static_cast<float>(worker->idleNanos)
+        });
+    }
+    return res;
+}
+
+void JobSystem::resetStats() {
+    for (std::unique_ptr<Worker> &worker : m_workers) {
+        worker->jobsRun = 0;
+        worker->jobsStolen = 0;
+        worker->busyNanos = 0;
+        worker->idleNanos = 0;
+    }
+}
+
+void JobSystem::m_schedule(const JobPtr &job) {
+    // Workers keep their own jobs local, everything else is spread round robin
+    const size_t target = (t_system == this) ? t_workerIndex : m_nextWorker++ % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock { m_workers[target]->mutex };
+        m_workers[target]->jobs.push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock { m_sleepMutex };
+        m_queuedCount++;
+    }
+    m_sleepCondition.notify_one();
+}
+
+void JobSystem::m_finish(const JobPtr &job) {
+    std::vector<JobPtr> dependents;
+    {
+        std::lock_guard<std::mutex> lock { job->mutex };
+        job->done = true;
+        dependents.swap(job->dependents);
+    }
+    job->func = nullptr;
+
+    for (const JobPtr &dependent : dependents) {
+        if (job->error) {
+            std::lock_guard<std::mutex> lock { dependent->mutex };
+            if (!dependent->error)
+                dependent->error = job->error;
+        }
+        m_release(dependent);
+    }
+}
+
+void JobSystem::m_release(const JobPtr &job) {
+    if (--job->pendingDependencies != 0)
+        return;
+
+    // A job whose dependency failed never runs, it fails with the same error
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock { job->mutex };
+        failed = static_cast<bool>(job->error);
+    }
+    if (failed)
+        m_finish(job);
+    else
+        m_schedule(job);
+}
+
+JobSystem::JobPtr JobSystem::m_takeJob(size_t preferred, bool &stolen) {
+    JobPtr job;
+    const size_t workerCount = m_workers.size();
+
+    // Own deque from the back (most recent, still in cache), others from the front
+    for (size_t i = 0; i < workerCount && !job; i++) {
+        const size_t index = (preferred + i) % workerCount;
+        Worker &worker = *m_workers[index];
+        std::lock_guard<std::mutex> lock { worker.mutex };
+        if (worker.jobs.empty())
+            continue;
+
+        stolen = (index != preferred);
+        if (stolen) {
+            job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+        } else {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+        }
+    }
+
+    if (job) {
+        std::lock_guard<std::mutex> lock { m_sleepMutex };
+        m_queuedCount--;
+    }
+    return job;
+}
+
+bool JobSystem::m_runOne() {
+    const bool isWorker = (t_system == this);
+    const size_t preferred = isWorker ? t_workerIndex : 0;
+
+    bool stolen = false;
+    JobPtr job = m_takeJob(preferred, stolen);
+    if (!job)
+        return false;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const uint64_t waitNanos = t_waitNanos;
+    t_jobDepth++;
+    try {
+        job->func();
+    } catch (...) {
+        job->error = std::current_exception();
+    }
+    t_jobDepth--;
+
+    if (isWorker) {
+        Worker &worker = *m_workers[t_workerIndex];
+        // Nested jobs already lie within the outermost one's time, yielding in wait() was counted as idle
+        if (t_jobDepth == 0) {
+            const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+            worker.busyNanos += elapsed - std::min(elapsed, t_waitNanos - waitNanos);
+        }
+        worker.jobsRun++;
+        if (stolen)
+            worker.jobsStolen++;
+    }
+
+    m_finish(job);
+    return true;
+}
+
+void JobSystem::m_workerLoop(size_t index) {
+    t_system = this;
+    t_workerIndex = index;
+    Worker &worker = *m_workers[index];
+
+    while (true) {
+        if (m_runOne())
+            continue;
+
+        const auto startTime = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock { m_sleepMutex };
+            m_sleepCondition.wait(lock, [this]() { return m_queuedCount > 0 || !m_running; });
+            if (!m_running && m_queuedCount == 0)
+                return;
+        }
+        worker.idleNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+}
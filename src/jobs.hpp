@@ -0,0 +1,130 @@
+#pragma once
+
+#include "imports.hpp"
+
+
+namespace shrekrooms::jobs {
+
+
+class JobSystem;
+
+
+class JobHandle {
+public:
+    JobHandle();
+
+    bool isValid() const;
+    bool isDone() const;
+
+protected:
+    friend JobSystem;
+
+    struct Job;
+    std::shared_ptr<Job> m_job;
+
+    JobHandle(std::shared_ptr<Job> job);
+
+};
+
+
+/*
+ * Work-stealing thread pool. Every worker owns a deque: it pushes and pops at the back,
+ * idle workers steal from the front of the others. A job only becomes runnable once
+ * all of its dependencies have finished
+*/
+class JobSystem {
+public:
+    using JobFunc = std::function<void()>;
+
+    struct WorkerStats {
+        uint64_t jobsRun;
+        uint64_t jobsStolen;
+        float busySeconds;
+        float idleSeconds;
+
+        // Share of the time spent running jobs, in [0; 1]
+        float getUtilisation() const;
+    };
+
+    // 0 workers picks one less than the hardware thread count
+    JobSystem(size_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator =(const JobSystem &) = delete;
+
+    size_t getWorkerCount() const;
+
+    // If a dependency throws, func never runs and waiting on the job rethrows that error
+    JobHandle submit(JobFunc func, const std::vector<JobHandle> &dependencies = { });
+    // Runs other jobs on the calling thread until handle is done, rethrows what the job threw
+    void wait(const JobHandle &handle);
+    void wait(const std::vector<JobHandle> &handles);
+
+    // Calls func(i) for every i in [begin; end), grainSize indices per job, and waits for all of them
+    template <typename _Func>
+    void parallelFor(size_t begin, size_t end, size_t grainSize, _Func func);
+
+    std::vector<WorkerStats> getStats() const;
+    void resetStats();
+
+protected:
+    using JobPtr = std::shared_ptr<JobHandle::Job>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<JobPtr> jobs;
+
+        std::atomic<uint64_t> jobsRun;
+        std::atomic<uint64_t> jobsStolen;
+        std::atomic<uint64_t> busyNanos;
+        std::atomic<uint64_t> idleNanos;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running;
+    std::atomic<size_t> m_nextWorker;   // Round robin target for jobs submitted from outside the pool
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    size_t m_queuedCount;               // Guarded by m_sleepMutex
+
+    static thread_local JobSystem *t_system;
+    static thread_local size_t t_workerIndex;
+    // Jobs running on this thread, nested ones are run by wait() inside a job
+    static thread_local size_t t_jobDepth;
+    // Time this worker spent yielding in wait(), counted as idle
+    static thread_local uint64_t t_waitNanos;
+
+    void m_schedule(const JobPtr &job);
+    void m_finish(const JobPtr &job);
+    // Drops one pending dependency, the last one schedules the job
+    void m_release(const JobPtr &job);
+    JobPtr m_takeJob(size_t preferred, bool &stolen);
+    bool m_runOne();
+    void m_workerLoop(size_t index);
+
+};
+
+
+template <typename _Func>
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, _Func func) {
+    if (begin >= end)
+        return;
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    std::vector<JobHandle> handles;
+    handles.reserve((end - begin + grainSize - 1) / grainSize);
+    for (size_t first = begin; first < end; first += grainSize) {
+        const size_t last = std::min(first + grainSize, end);
+        handles.push_back(submit([&func, first, last]() {
+            for (size_t i = first; i < last; i++)
+                func(i);
+        }));
+    }
+    wait(handles);
+}
+
+
+} // namespace shrekrooms::jobs
@@ -1,67 +1,184 @@
 #include "glc.hpp"
+#include "input.hpp"
 #include "player.hpp"
 #include "shrek.hpp"
+#include "simulation.hpp"
+#include "renderer.hpp"
+#include "save_state.hpp"
+
+
+static shrekrooms::PlayerInput sampleInput(shrekrooms::gl::InputState &input) {
+    using namespace shrekrooms;
+
+    PlayerInput res;
+    const float mouseDeltaX = input.takeMouseDelta().x;
+    if (!input.isFocused())
+        return res;
+
+    res.forward  = input.isKeyDown(defines::controls::keyForward);
+    res.backward = input.isKeyDown(defines::controls::keyBackward);
+    res.left     = input.isKeyDown(defines::controls::keyLeft);
+    res.right    = input.isKeyDown(defines::controls::keyRight);
+    res.mouseDeltaX = mouseDeltaX;
+
+    return res;
+}
 
 
 int main(int argc, const char **argv) {
     using namespace shrekrooms;
 
-    gl::GLContext glc { 640*2, 480*2, "Shrekrooms", false, GLFW_KEY_ESCAPE };
+    // Recordings are replayed by the headless build
+    std::string recordPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::string_view { argv[i] } == "--record" && i+1 < argc)
+            recordPath = argv[++i];
+    }
+
+    // Everything the start-up jobs touch is declared before the jobs, so it outlives
+    // the workers even when unwinding past a job that is still running
+    StartupLog startup;
     rng::Random random;
+    std::unique_ptr<maze::Maze> maze;
+    std::unique_ptr<World> world;
+    jobs::JobSystem jobs;
+
+    // The maze and world are built on the workers while the window and shaders are set up
+    const jobs::JobHandle mazeJob = jobs.submit([&]() {
+        const auto begin = StartupLog::Clock::now();
+        maze = std::make_unique<maze::Maze>(random, defines::world::chunksCountWidth, defines::world::bridgePercentage);
+        startup.add("maze", begin);
+    });
+    const jobs::JobHandle worldJob = jobs.submit([&]() {
+        const auto begin = StartupLog::Clock::now();
+        world = std::make_unique<World>(*maze, jobs);
+        startup.add("world", begin);
+    }, { mazeJob });
+
+    gl::GLContext glc { jobs, 640*2, 480*2, "Shrekrooms", false, GLFW_KEY_ESCAPE, &startup };
 
     const UniformManager &uniman  = glc.getUniformManager();
-    const TextureManager &texman  = glc.getUniformManager();
     const MeshManager    &meshman = glc.getMeshManager();
 
     gl::Color bgcol { 0.2f, 0.2f, 0.2f };
     glc.setBackgroundColor(bgcol);
 
-    maze::Maze maze { random, defines::world::chunksCountWidth, defines::world::bridgePercentage };
-    World world { glc, maze };
+    auto begin = StartupLog::Clock::now();
+    jobs.wait(worldJob);
+    startup.add("wait for world", begin);
 
-    Player player { glc, { 0.0f, 0.0f, 0.0f }, 0.0f };
-    Shrek shrek { glc, maze, { 5, 5 } };
+    begin = StartupLog::Clock::now();
+    Renderer renderer { glc, *world };
+
+    Simulation sim { *world, jobs };
+    const ecs::EntityID playerId = spawnPlayer(sim.getRegistry(), { }, 0.0f, 0);
+    spawnShrek(sim.getRegistry(), *maze, { 5, 5 }, playerId);
+    startup.add("simulation", begin);
 
     glc.enableShader();
     uniman.setColor({ 1.0f, 0.0f, 1.0f });
     uniman.setFogColor(bgcol);
 
-    float deltaTime = 0.001f;
-    decltype(std::chrono::steady_clock::now()) currentTime;
-    glc.setCursorPos({ 0.0f, 0.0f });
-    glc.hideCursor();
+    glc.setCursorCaptured(true);
+    gl::InputState input;
+
+    InputLog record { random.getSeed() };
+    SimulationThread simThread { sim, recordPath.empty() ? nullptr : &record };
+
+    // Only touched by tasks posted to the simulation thread
+    std::vector<uint8_t> quickSave;
+
     bool paused = false;
+    bool isFirstFrame = true;
+    SimSnapshot prevSnapshot, currSnapshot;
+    float alpha;
     while (glc.isRunning()) {
-        currentTime = std::chrono::steady_clock::now();
-
-        glfwPollEvents();
+        glc.pollEvents();
+        input.update(glc);
 
-        if (glc.isMouseButtonClicked(GLFW_MOUSE_BUTTON_RIGHT)) {
+        if (input.wasMouseButtonClicked(GLFW_MOUSE_BUTTON_RIGHT)) {
             paused = !paused;
-            if (paused)
-                glc.showCursor();
-            else
-                glc.hideCursor();
+            simThread.setPaused(paused);
+            glc.setCursorCaptured(!paused);
         }
 
-        if (!paused) {
-            player.update(world, deltaTime);
-            shrek.update(world, player, deltaTime);
-            // if (shrek.isCollidingPlayer())
-            //     break;
+        if (input.wasKeyPressed(defines::controls::keyQuickSave))
+            simThread.post([&quickSave](Simulation &sim) { save::writeState(sim, quickSave); });
+        // A recording only holds input, it can't replay a jump back to a saved state
+        if (input.wasKeyPressed(defines::controls::keyQuickLoad) && !recordPath.empty()) {
+            std::cout << "Quick load is disabled while recording\n";
+        } else if (input.wasKeyPressed(defines::controls::keyQuickLoad)) {
+            simThread.post([&quickSave](Simulation &sim) {
+                if (!quickSave.empty())
+                    save::readState(quickSave, sim);
+            });
         }
+        if (input.wasKeyPressed(defines::controls::keyPrintStats)) {
+            const Renderer::Stats &stats = renderer.getStats();
+            std::cout << "Chunks: " << stats.chunksVisible << " drawn, " << stats.chunksCulled << " culled ("
+                      << stats.blocksCulled << " blocks, " << stats.chunksOccluded << " behind walls)\n"
+                      << "Entities: " << stats.entitiesVisible << " drawn, " << stats.entitiesCulled << " culled\n";
+
+            // Counted since the last print
+            const gl::StateCache::Stats &calls = glc.getStateCache().getStats();
+            std::cout << "GL calls made/skipped: program " << calls.programBinds << '/' << calls.programSkips
+                      << ", vao " << calls.vaoBinds << '/' << calls.vaoSkips
+                      << ", texture " << calls.textureBinds << '/' << calls.textureSkips
+                      << ", uniform " << calls.uniformUploads << '/' << calls.uniformSkips << '\n';
+            glc.getStateCache().resetStats();
+        }
+        if (input.wasKeyPressed(defines::controls::keyFogDenser) || input.wasKeyPressed(defines::controls::keyFogThinner)) {
+            const float factor = input.wasKeyPressed(defines::controls::keyFogDenser) ? 1.25f : 0.8f;
+            renderer.setFog(renderer.getFogStart(), factor * renderer.getFogDensity());
+            std::cout << "Fog density " << renderer.getFogDensity() << ", view distance " << renderer.getViewDistance() << '\n';
+        }
+        input.clearEdges();
+
+        simThread.getSnapshots(prevSnapshot, currSnapshot, alpha);
+        const SimSnapshot snapshot = SimSnapshot::interpolate(prevSnapshot, currSnapshot, alpha);
+        const EntitySnapshot *viewer = snapshot.find(playerId);
 
         glc.enableShader();
         glc.clearBackground();
 
-        shrek.draw(player);
-        world.draw();
+        if (viewer)
+            renderer.update(viewer->pos);
+
+        // Sampled as late as possible, so input arriving during the frame still turns its view
+        glc.pollEvents();
+        input.update(glc);
+        if (paused)
+            input.takeMouseDelta();
+        else
+            simThread.addInput(sampleInput(input));
+
+        if (viewer) {
+            // The newest heading plus the turn still waiting for a tick, read in this
+            // order a tick in between can only drop one tick of turn, never add it twice
+            EntitySnapshot view = *viewer;
+            const EntitySnapshot *currViewer = currSnapshot.find(playerId);
+            view.rot = currViewer->rot + defines::player::mouseSensitivity * Simulation::s_getTickDuration() * simThread.getPendingMouseDeltaX();
+
+            renderer.setView(view);
+            renderer.drawSprites(snapshot);
+            renderer.drawWorld();
+        }
 
         glc.drawBuffer();
-        deltaTime = std::chrono::duration_cast<DurationSecondsFloat>(std::chrono::steady_clock::now() - currentTime).count();
-        // glfwSetWindowTitle(glc.getWindow().ptr, std::to_string(100 * static_cast<int>(0.01f / deltaTime)).c_str());
+
+        if (isFirstFrame) {
+            std::cout << "Startup:\n";
+            startup.print(std::cout, "Time to first frame");
+            isFirstFrame = false;
+        }
+    }
+    glc.setCursorCaptured(false);
+
+    simThread.stop();
+    if (!recordPath.empty()) {
+        record.setFinalHash(sim.getStateHash());
+        record.save(recordPath);
     }
-    glc.showCursor();
     
     return 0;
 }
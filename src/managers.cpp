@@ -7,8 +7,8 @@ using namespace shrekrooms;
  * class shrekrooms::UniformManager
 */
 
-UniformManager::UniformManager(GLuint shader) :
-        m_shader(shader) {
+UniformManager::UniformManager(GLuint shader, gl::StateCache &state) :
+        m_shader(shader), m_state(state) {
     m_uniforms[s_uniformToId(Uniform::Translate)]  = m_getUniformLocation("u_translate");
     m_uniforms[s_uniformToId(Uniform::Rotate)]     = m_getUniformLocation("u_rotate");
     m_uniforms[s_uniformToId(Uniform::View)]       = m_getUniformLocation("u_view");
@@ -16,46 +16,56 @@ UniformManager::UniformManager(GLuint shader) :
     m_uniforms[s_uniformToId(Uniform::Color)]      = m_getUniformLocation("u_color");
     m_uniforms[s_uniformToId(Uniform::ViewPos)]    = m_getUniformLocation("u_viewPos");
     m_uniforms[s_uniformToId(Uniform::FogColor)]   = m_getUniformLocation("u_fogColor");
+    m_uniforms[s_uniformToId(Uniform::FogStart)]   = m_getUniformLocation("u_fogStart");
+    m_uniforms[s_uniformToId(Uniform::FogDensity)] = m_getUniformLocation("u_fogDensity");
 }
 
 // Uniforms
 void UniformManager::useTexture(gl::Texture tex) const {
-    glBindTexture(GL_TEXTURE_2D, tex);
+    m_state.bindTexture(tex);
 }
 
 void UniformManager::setTranslateMatrix(const glm::mat4 &translateMat) const {
-    glUniformMatrix4fv(m_uniforms[s_uniformToId(Uniform::Translate)], 1, GL_FALSE, glm::value_ptr(translateMat));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::Translate)], translateMat);
 }
 
 void UniformManager::setRotateMatrix(const glm::mat4 &rotateMat) const {
-    glUniformMatrix4fv(m_uniforms[s_uniformToId(Uniform::Rotate)], 1, GL_FALSE, glm::value_ptr(rotateMat));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::Rotate)], rotateMat);
 }
 
 void UniformManager::UniformManager::setViewMatrix(const glm::mat4 &viewMat) const {
-    glUniformMatrix4fv(m_uniforms[s_uniformToId(Uniform::View)], 1, GL_FALSE, glm::value_ptr(viewMat));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::View)], viewMat);
 }
 
 void UniformManager::setProjectionMatrix(const glm::mat4 &projectionMat) const {
-    glUniformMatrix4fv(m_uniforms[s_uniformToId(Uniform::Projection)], 1, GL_FALSE, glm::value_ptr(projectionMat));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::Projection)], projectionMat);
 }
 
 void UniformManager::setColor(const gl::Color &color) const {
-    glUniform4fv(m_uniforms[s_uniformToId(Uniform::Color)], 1, glm::value_ptr(static_cast<glm::vec4>(color)));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::Color)], static_cast<glm::vec4>(color));
 }
 
 void UniformManager::setFogColor(const gl::Color &color) const {
-    glUniform4fv(m_uniforms[s_uniformToId(Uniform::FogColor)], 1, glm::value_ptr(static_cast<glm::vec4>(color)));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::FogColor)], static_cast<glm::vec4>(color));
+}
+
+void UniformManager::setFogStart(float start) const {
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::FogStart)], start);
+}
+
+void UniformManager::setFogDensity(float density) const {
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::FogDensity)], density);
 }
 
 void UniformManager::setViewPos(const glm::vec3 &pos) const {
-    glUniform3fv(m_uniforms[s_uniformToId(Uniform::ViewPos)], 1, glm::value_ptr(pos));
+    m_state.setUniform(m_uniforms[s_uniformToId(Uniform::ViewPos)], pos);
 }
 
 constexpr size_t UniformManager::s_uniformToId(Uniform uniform) {
     return static_cast<size_t>(uniform) - 1;
 }
 
-GLuint UniformManager::m_getUniformLocation(const std::string &name) const {
+GLint UniformManager::m_getUniformLocation(const std::string &name) const {
     return glGetUniformLocation(m_shader, name.c_str());
 }
 
@@ -64,11 +74,17 @@ GLuint UniformManager::m_getUniformLocation(const std::string &name) const {
  * class shrekrooms::TextureManager
 */
 
-TextureManager::TextureManager(const UniformManager &uniman) :
+// In TextureID order
+const std::array<std::string_view, TextureManager::s_texCount> TextureManager::s_texPaths {
+    "../img/floor.jpg",
+    "../img/wall.jpg",
+    "../img/shrek.jpg"
+};
+
+TextureManager::TextureManager(const UniformManager &uniman, const Images &images) :
         m_uniman(uniman), m_textures() {
-    m_textures[s_textureToId(TextureID::Floor)] = gl::loadTexture("../img/floor.jpg");
-    m_textures[s_textureToId(TextureID::Wall)] = gl::loadTexture("../img/wall.jpg");
-    m_textures[s_textureToId(TextureID::Shrek)] = gl::loadTexture("../img/shrek.jpg");
+    for (size_t i = 0; i < s_texCount; i++)
+        m_textures[i] = gl::uploadTexture(images[i]);
 }
 
 TextureManager::~TextureManager() {
@@ -79,6 +95,14 @@ gl::Texture TextureManager::getTexture(TextureID texture) const {
     return m_textures[s_textureToId(texture)];
 }
 
+TextureManager::Images TextureManager::s_decodeImages(jobs::JobSystem &jobs) {
+    Images images;
+    jobs.parallelFor(0, s_texCount, 1, [&images](size_t i) {
+        images[i] = gl::decodeImage(std::string { s_texPaths[i] });
+    });
+    return images;
+}
+
 constexpr size_t TextureManager::s_textureToId(TextureID texture) {
     return static_cast<size_t>(texture) - 1;
 }
@@ -88,12 +112,12 @@ constexpr size_t TextureManager::s_textureToId(TextureID texture) {
  * class shrekrooms::MeshManager
 */
 
-MeshManager::MeshManager(const UniformManager &uniman, const TextureManager &texman) :
-        m_uniman(uniman), m_texman(texman) {
+MeshManager::MeshManager(const UniformManager &uniman, const TextureManager &texman, gl::StateCache &state) :
+        m_texman(texman), m_uniman(uniman), m_state(state) {
     m_genChunkFloor();
-    m_genChunkWallXPos();
+    m_genChunkWallX();
     m_genChunkWallXNeg();
-    m_genChunkWallZPos();
+    m_genChunkWallZ();
     m_genChunkWallZneg();
     m_genShrek();
 }
@@ -107,29 +131,77 @@ void MeshManager::renderMesh(Mesh mesh) const {
     m_uniman.useTexture(m_textures[meshId]);
 
     const gl::Geometry &geo = m_geometries[meshId];
-    glBindVertexArray(geo.vao);
+    m_state.bindVertexArray(geo.vao);
     glDrawArrays(GL_TRIANGLES, 0, geo.vertCount);
 }
 
+void MeshManager::renderMeshInstanced(Mesh mesh, const gl::InstanceBuffer &instances) const {
+    if (mesh == Mesh::Null || instances.instanceCount == 0)
+        return;
+
+    const size_t meshId = s_meshToId(mesh);
+
+    m_uniman.useTexture(m_textures[meshId]);
+
+    m_state.bindVertexArray(instances.vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, m_geometries[meshId].vertCount, instances.instanceCount);
+}
+
+void MeshManager::initInstanceBuffer(Mesh mesh, gl::InstanceBuffer &instances) const {
+    const gl::Geometry &geo = m_geometries[s_meshToId(mesh)];
+
+    glGenVertexArrays(1, &instances.vao);
+    m_state.bindVertexArray(instances.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, geo.vbo);
+    s_setVertexAttributes();
+
+    glGenBuffers(1, &instances.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instances.vbo);
+    /* Instance offset */
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3*sizeof(GLfloat), (void*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    instances.instanceCount = 0;
+}
+
+void MeshManager::s_setInstanceOffsets(gl::InstanceBuffer &instances, const std::vector<glm::vec3> &offsets) {
+    glBindBuffer(GL_ARRAY_BUFFER, instances.vbo);
+    glBufferData(GL_ARRAY_BUFFER, offsets.size()*sizeof(glm::vec3), offsets.data(), GL_DYNAMIC_DRAW);
+    instances.instanceCount = offsets.size();
+}
+
 constexpr size_t MeshManager::s_meshToId(Mesh mesh) {
     return static_cast<size_t>(mesh) - 1;
 }
 
-void MeshManager::m_bindGeometry(gl::Geometry &geometry, const std::vector<float> &verts) {
-    static constexpr size_t stride = 5;
+void MeshManager::s_setVertexAttributes() {
+    /* Position */
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, s_vertexStride*sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    /* Texture coordinates */
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, s_vertexStride*sizeof(GLfloat), (void*)(3*sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+}
+
+const std::vector<float> &MeshManager::getVertices(Mesh mesh) const {
+    return m_vertices[s_meshToId(mesh)];
+}
+
+gl::Texture MeshManager::getTexture(Mesh mesh) const {
+    return m_textures[s_meshToId(mesh)];
+}
+
+void MeshManager::m_bindGeometry(size_t meshId, const std::vector<float> &verts) {
+    gl::Geometry &geometry = m_geometries[meshId];
+    m_vertices[meshId] = verts;
 
     glGenVertexArrays(1, &geometry.vao);
-    glBindVertexArray(geometry.vao);
+    m_state.bindVertexArray(geometry.vao);
     glGenBuffers(1, &geometry.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo);
     glBufferData(GL_ARRAY_BUFFER, verts.size()*sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
-    /* Position */
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride*sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
-    /* Texture coordinates */
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride*sizeof(GLfloat), (void*)(3*sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-    geometry.vertCount = verts.size() / stride;
+    s_setVertexAttributes();
+    geometry.vertCount = verts.size() / s_vertexStride;
 }
 
 #define _M_SHREKROOMS_DEFINE_WORLD_DATA_CONSTEXPR()                                                 \
@@ -137,6 +209,7 @@ void MeshManager::m_bindGeometry(gl::Geometry &geometry, const std::vector<float
     const float ymax = 0.5f * defines::world::chunkHeight;                                          \
     const float wmax = pmax - defines::world::wallThicknessHalf;                                    \
     const float gmax = pmax + defines::world::wallThicknessHalf - 2.0f*defines::epsilon;            \
+    [[maybe_unused]] const float nmax = pmax + defines::world::wallThicknessHalf;                   \
     const float tfmax = defines::world::chunkFloorTiles;                                            \
     const float twmax = defines::world::chunkWallTiles;                                             \
     const float tgmax = twmax * (2.0f * defines::world::wallThicknessHalf / defines::world::chunkSize);
@@ -147,7 +220,6 @@ void MeshManager::m_genChunkFloor() {
     const size_t meshId = s_meshToId(Mesh::ChunkFloor);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Floor);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     std::vector<float> verts {
         // floor
@@ -167,19 +239,18 @@ void MeshManager::m_genChunkFloor() {
         -pmax,  ymax, -pmax,  0.0f,  tfmax,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
 
-void MeshManager::m_genChunkWallXPos() {
+void MeshManager::m_genChunkWallX() {
     _M_SHREKROOMS_DEFINE_WORLD_DATA_CONSTEXPR();
 
-    const size_t meshId = s_meshToId(Mesh::ChunkWallXPos);
+    const size_t meshId = s_meshToId(Mesh::ChunkWallX);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Wall);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     std::vector<float> verts {
-        // main
+        // main (this chunk)
          wmax, -ymax, -gmax,    0.0f,  twmax,
          wmax, -ymax,  gmax,    twmax, twmax,
          wmax,  ymax,  gmax,    twmax, 0.0f,
@@ -187,23 +258,31 @@ void MeshManager::m_genChunkWallXPos() {
          wmax,  ymax,  gmax,    twmax, 0.0f,
          wmax,  ymax, -gmax,    0.0f,  0.0f,
 
+        // main (x+ neighbour)
+         nmax, -ymax,  gmax,    0.0f,  twmax,
+         nmax, -ymax, -gmax,    twmax, twmax,
+         nmax,  ymax, -gmax,    twmax, 0.0f,
+         nmax, -ymax,  gmax,    0.0f,  twmax,
+         nmax,  ymax, -gmax,    twmax, 0.0f,
+         nmax,  ymax,  gmax,    0.0f,  0.0f,
+
         // sides
-         pmax, -ymax, -gmax,    0.0f,  twmax,
+         nmax, -ymax, -gmax,    0.0f,  twmax,
          wmax, -ymax, -gmax,    tgmax, twmax,
          wmax,  ymax, -gmax,    tgmax, 0.0f,
-         pmax, -ymax, -gmax,    0.0f,  twmax,
+         nmax, -ymax, -gmax,    0.0f,  twmax,
          wmax,  ymax, -gmax,    tgmax, 0.0f,
-         pmax,  ymax, -gmax,    0.0f,  0.0f,
+         nmax,  ymax, -gmax,    0.0f,  0.0f,
 
          wmax, -ymax,  gmax,    0.0f,  twmax,
-         pmax, -ymax,  gmax,    tgmax, twmax,
-         pmax,  ymax,  gmax,    tgmax, 0.0f,
+         nmax, -ymax,  gmax,    tgmax, twmax,
+         nmax,  ymax,  gmax,    tgmax, 0.0f,
          wmax, -ymax,  gmax,    0.0f,  twmax,
-         pmax,  ymax,  gmax,    tgmax, 0.0f,
+         nmax,  ymax,  gmax,    tgmax, 0.0f,
          wmax,  ymax,  gmax,    0.0f,  0.0f,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
 
 void MeshManager::m_genChunkWallXNeg() {
@@ -212,7 +291,6 @@ void MeshManager::m_genChunkWallXNeg() {
     const size_t meshId = s_meshToId(Mesh::ChunkWallXNeg);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Wall);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     std::vector<float> verts {
         // main
@@ -239,43 +317,50 @@ void MeshManager::m_genChunkWallXNeg() {
         -pmax,  ymax,  gmax,    0.0f,  0.0f,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
 
-void MeshManager::m_genChunkWallZPos() {
+void MeshManager::m_genChunkWallZ() {
     _M_SHREKROOMS_DEFINE_WORLD_DATA_CONSTEXPR();
 
-    const size_t meshId = s_meshToId(Mesh::ChunkWallZPos);
+    const size_t meshId = s_meshToId(Mesh::ChunkWallZ);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Wall);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     std::vector<float> verts {
-        // main
+        // main (this chunk)
          gmax, -ymax,  wmax,    0.0f,  twmax,
         -gmax, -ymax,  wmax,    twmax, twmax,
         -gmax,  ymax,  wmax,    twmax, 0.0f,
          gmax, -ymax,  wmax,    0.0f,  twmax,
         -gmax,  ymax,  wmax,    twmax, 0.0f,
-            gmax,  ymax,  wmax,    0.0f,  0.0f,
+         gmax,  ymax,  wmax,    0.0f,  0.0f,
+
+        // main (z+ neighbour)
+        -gmax, -ymax,  nmax,    0.0f,  twmax,
+         gmax, -ymax,  nmax,    twmax, twmax,
+         gmax,  ymax,  nmax,    twmax, 0.0f,
+        -gmax, -ymax,  nmax,    0.0f,  twmax,
+         gmax,  ymax,  nmax,    twmax, 0.0f,
+        -gmax,  ymax,  nmax,    0.0f,  0.0f,
 
         // sides
-        -gmax, -ymax,  pmax,    0.0f,  twmax,
-        -gmax, -ymax,  gmax,    tgmax, twmax,
-        -gmax,  ymax,  gmax,    tgmax, 0.0f,
-        -gmax, -ymax,  pmax,    0.0f,  twmax,
-        -gmax,  ymax,  gmax,    tgmax, 0.0f,
-        -gmax,  ymax,  pmax,    0.0f,  0.0f,
-
-         gmax, -ymax,  gmax,    0.0f,  twmax,
-         gmax, -ymax,  pmax,    tgmax, twmax,
-         gmax,  ymax,  pmax,    tgmax, 0.0f,
-         gmax, -ymax,  gmax,    0.0f,  twmax,
-         gmax,  ymax,  pmax,    tgmax, 0.0f,
-         gmax,  ymax,  gmax,    0.0f,  0.0f,
+        -gmax, -ymax,  wmax,    0.0f,  twmax,
+        -gmax, -ymax,  nmax,    tgmax, twmax,
+        -gmax,  ymax,  nmax,    tgmax, 0.0f,
+        -gmax, -ymax,  wmax,    0.0f,  twmax,
+        -gmax,  ymax,  nmax,    tgmax, 0.0f,
+        -gmax,  ymax,  wmax,    0.0f,  0.0f,
+
+         gmax, -ymax,  nmax,    0.0f,  twmax,
+         gmax, -ymax,  wmax,    tgmax, twmax,
+         gmax,  ymax,  wmax,    tgmax, 0.0f,
+         gmax, -ymax,  nmax,    0.0f,  twmax,
+         gmax,  ymax,  wmax,    tgmax, 0.0f,
+         gmax,  ymax,  nmax,    0.0f,  0.0f,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
 
 void MeshManager::m_genChunkWallZneg() {
@@ -284,7 +369,6 @@ void MeshManager::m_genChunkWallZneg() {
     const size_t meshId = s_meshToId(Mesh::ChunkWallZNeg);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Wall);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     std::vector<float> verts {
         // main
@@ -311,14 +395,13 @@ void MeshManager::m_genChunkWallZneg() {
         -gmax,  ymax, -gmax,    0.0f,  0.0f,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
 
 void shrekrooms::MeshManager::m_genShrek() {
     const size_t meshId = s_meshToId(Mesh::Shrek);
 
     m_textures[meshId] = m_texman.getTexture(TextureManager::TextureID::Shrek);
-    gl::Geometry &geometry = m_geometries[meshId];
 
     const float smax = 0.5f * defines::shrek::width;
     const float ymin = 0.5f * defines::world::chunkHeight;
@@ -333,5 +416,5 @@ void shrekrooms::MeshManager::m_genShrek() {
         0.0f,  ymax, -smax,    0.0f, 0.0f,
     };
 
-    m_bindGeometry(geometry, verts);
+    m_bindGeometry(meshId, verts);
 }
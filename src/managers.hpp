@@ -2,6 +2,8 @@
 
 #include "defines.hpp"
 #include "gl_util.hpp"
+#include "gl_state.hpp"
+#include "jobs.hpp"
 
 
 namespace shrekrooms {
@@ -18,10 +20,13 @@ public:
         Projection,
         Color,
         ViewPos,
-        FogColor
+        FogColor,
+        FogStart,
+        FogDensity
     };
 
-    UniformManager(GLuint shader);
+    // Every call goes through the state cache
+    UniformManager(GLuint shader, gl::StateCache &state);
 
     // Uniforms
     void useTexture(gl::Texture tex) const;
@@ -31,16 +36,19 @@ public:
     void setProjectionMatrix(const glm::mat4 &projectionMat) const;
     void setColor(const gl::Color &color) const;
     void setFogColor(const gl::Color &color) const;
+    void setFogStart(float start) const;
+    void setFogDensity(float density) const;
     void setViewPos(const glm::vec3 &pos) const;
 
 protected:
-    static constexpr size_t s_uniformCount = 6;
-    std::array<GLuint, s_uniformCount> m_uniforms;
+    static constexpr size_t s_uniformCount = static_cast<size_t>(Uniform::FogDensity);
+    std::array<GLint, s_uniformCount> m_uniforms;
     GLuint m_shader;
+    gl::StateCache &m_state;
 
     static constexpr size_t s_uniformToId(Uniform uniform);
 
-    GLuint m_getUniformLocation(const std::string &name) const;
+    GLint m_getUniformLocation(const std::string &name) const;
 
 };
 
@@ -55,13 +63,20 @@ public:
         Shrek
     };
 
-    TextureManager(const UniformManager &uniman);
+    static constexpr size_t s_texCount = 3;
+    using Images = std::array<gl::Image, s_texCount>;
+
+    // Uploads images from s_decodeImages(), needs the GL context
+    TextureManager(const UniformManager &uniman, const Images &images);
     ~TextureManager();
 
     gl::Texture getTexture(TextureID texture) const;
 
+    // Decodes on the job system, safe to run without a GL context
+    static Images s_decodeImages(jobs::JobSystem &jobs);
+
 protected:
-    static constexpr size_t s_texCount = 3;
+    static const std::array<std::string_view, s_texCount> s_texPaths;
     const UniformManager &m_uniman;
     std::array<gl::Texture, s_texCount> m_textures;
 
@@ -76,32 +91,50 @@ public:
         Null = 0,
 
         ChunkFloor,
-        ChunkWallXPos,
-        ChunkWallXNeg,
-        ChunkWallZPos,
-        ChunkWallZNeg,
+        ChunkWallX,     // Shared by two chunks, spans the x+ border
+        ChunkWallXNeg,  // Maze border only
+        ChunkWallZ,     // Shared by two chunks, spans the z+ border
+        ChunkWallZNeg,  // Maze border only
         Shrek
     };
 
-    MeshManager(const UniformManager &uniman, const TextureManager &texman);
+    // Position (3) and texture coordinates (2)
+    static constexpr size_t s_vertexStride = 5;
+
+    MeshManager(const UniformManager &uniman, const TextureManager &texman, gl::StateCache &state);
 
     void renderMesh(Mesh mesh) const;
+    // Every instance is the mesh moved by its offset
+    void renderMeshInstanced(Mesh mesh, const gl::InstanceBuffer &instances) const;
+
+    void initInstanceBuffer(Mesh mesh, gl::InstanceBuffer &instances) const;
+    static void s_setInstanceOffsets(gl::InstanceBuffer &instances, const std::vector<glm::vec3> &offsets);
+
+    // CPU copy of the vertices, for baking meshes into other buffers
+    const std::vector<float> &getVertices(Mesh mesh) const;
+    gl::Texture getTexture(Mesh mesh) const;
+
+    // Layout of the bound array buffer, attribute 2 is left disabled and reads as 0
+    static void s_setVertexAttributes();
 
 protected:
     static constexpr size_t s_meshCount = 6;
     const TextureManager &m_texman;
     const UniformManager &m_uniman;
+    gl::StateCache &m_state;
     std::array<gl::Geometry, s_meshCount> m_geometries;
     std::array<gl::Texture, s_meshCount> m_textures;
 
+    std::array<std::vector<float>, s_meshCount> m_vertices;
+
     static constexpr size_t s_meshToId(Mesh mesh);
 
-    void m_bindGeometry(gl::Geometry &geometry, const std::vector<float> &verts);
+    void m_bindGeometry(size_t meshId, const std::vector<float> &verts);
 
     void m_genChunkFloor();
-    void m_genChunkWallXPos();
+    void m_genChunkWallX();
     void m_genChunkWallXNeg();
-    void m_genChunkWallZPos();
+    void m_genChunkWallZ();
     void m_genChunkWallZneg();
     void m_genShrek();
 
@@ -55,12 +55,23 @@ bool MazeNode::hasWall(Direction dir) const {
 }
 
 
+/*
+ * struct shrekrooms::maze::MazeRayHit
+*/
+
+MazeRayHit::MazeRayHit() :
+    isHit(false), dist(0.0f), cell(0), wall(Direction::Null) { }
+
+MazeRayHit::MazeRayHit(float dist, const glm::ivec2 &cell, Direction wall) :
+    isHit(true), dist(dist), cell(cell), wall(wall) { }
+
+
 /*
  * class shrekrooms::maze::Maze
 */
 
 Maze::Maze(rng::Random &random, size_t size, float bridgePercent) :
-        m_random(random), m_nodes(size, size) {
+        m_random(&random), m_nodes(size, size) {
     m_generateMainPath();
     m_addBridges(size, bridgePercent);
 #if (_MAZE_DESMOS_OUTPUT == 1)
@@ -84,14 +95,87 @@ Maze::Maze(rng::Random &random, size_t size, float bridgePercent) :
 #endif
 };
 
+Maze::Maze(size_t size, const std::vector<Direction> &walls) :
+        m_random(nullptr), m_nodes(size, size) {
+    if (walls.size() != size*size)
+        throw error { "maze.cpp", "shrekrooms::maze::Maze::Maze", "'walls' has to hold size*size cells" };
+
+    for (int x = 0; x < static_cast<int>(size); x++) {
+        for (int y = 0; y < static_cast<int>(size); y++)
+            m_nodes[{ x, y }].walls = walls[x*size + y];
+    }
+}
+
+size_t Maze::getSize() const {
+    return m_nodes.width();
+}
+
 const MazeNode &Maze::getNode(const glm::ivec2 &pos) const {
     return m_nodes.at(pos);
 }
 
+bool Maze::isInside(const glm::ivec2 &pos) const {
+    return (
+        0 <= pos.x && pos.x < static_cast<int>(m_nodes.width()) &&
+        0 <= pos.y && pos.y < static_cast<int>(m_nodes.height())
+    );
+}
+
+MazeRayHit Maze::raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const {
+    static const float inf = std::numeric_limits<float>::infinity();
+
+    glm::ivec2 cell = static_cast<glm::ivec2>(glm::floor(origin + 0.5f));
+    if (!isInside(cell))
+        return { 0.0f, cell, Direction::Null };
+
+    const glm::ivec2 step {
+        (dir.x > 0.0f) ? 1 : -1,
+        (dir.y > 0.0f) ? 1 : -1
+    };
+    const std::array<Direction, 2> crossed {
+        (step.x > 0) ? Direction::XPos : Direction::XNeg,
+        (step.y > 0) ? Direction::ZPos : Direction::ZNeg
+    };
+
+    // Ray length per crossed cell and to the first cell border, per axis
+    glm::vec2 tDelta, tMax;
+    for (int axis = 0; axis < 2; axis++) {
+        if (dir[axis] == 0.0f) {
+            tDelta[axis] = inf;
+            tMax[axis] = inf;
+            continue;
+        }
+        tDelta[axis] = std::abs(1.0f / dir[axis]);
+        const float border = static_cast<float>(cell[axis]) + 0.5f * static_cast<float>(step[axis]);
+        tMax[axis] = (border - origin[axis]) / dir[axis];
+    }
+
+    while (true) {
+        const int axis = (tMax.x < tMax.y) ? 0 : 1;
+        if (tMax[axis] > maxDist)
+            return { };
+
+        if (m_nodes.at(cell).hasWall(crossed[axis]))
+            return { tMax[axis], cell, crossed[axis] };
+
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        if (!isInside(cell))
+            return { tMax[axis] - tDelta[axis], cell, crossed[axis] };
+    }
+}
+
+bool Maze::hasLineOfSight(const glm::vec2 &from, const glm::vec2 &to) const {
+    const float dist = glm::distance(from, to);
+    if (dist == 0.0f)
+        return isInside(static_cast<glm::ivec2>(glm::floor(from + 0.5f)));
+    return !raycast(from, (to - from) / dist, dist).isHit;
+}
+
 Direction Maze::m_getRngDirection(const glm::ivec2 &pos, bool nextShouldBeEmpty) {
-    static rng::RandInt randLen2 = m_random.getRandInt(0, 1);
-    static rng::RandInt randLen3 = m_random.getRandInt(0, 2);
-    static rng::RandInt randLen4 = m_random.getRandInt(0, 3);
+    static rng::RandInt randLen2 = m_random->getRandInt(0, 1);
+    static rng::RandInt randLen3 = m_random->getRandInt(0, 2);
+    static rng::RandInt randLen4 = m_random->getRandInt(0, 3);
 
     std::vector<Direction> res;
     res.reserve(4);
@@ -151,7 +235,7 @@ void Maze::m_addBridges(size_t size, float bridgePercent) {
     if (bridgePercent < 0.0f || bridgePercent > 1.0f)
         throw error { "maze.cpp", "shrekrooms::maze::Maze::m_addBridges", "'bridgePercent' has to be in [0;1]" };
 
-    rng::RandInt randCoord = m_random.getRandInt(0, size-1);
+    rng::RandInt randCoord = m_random->getRandInt(0, size-1);
 
     const size_t bridgeCount = static_cast<size_t>(size*size * bridgePercent);
     for (size_t i = 0; i < bridgeCount; i++) {
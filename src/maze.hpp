@@ -46,14 +46,35 @@ struct MazeNode {
 };
 
 
+// Grid space: cell (x, y) covers [x-0.5; x+0.5] x [y-0.5; y+0.5]
+struct MazeRayHit {
+    bool isHit;
+    float dist;
+    glm::ivec2 cell;
+    Direction wall;
+
+    MazeRayHit();
+    MazeRayHit(float dist, const glm::ivec2 &cell, Direction wall);
+
+};
+
+
 class Maze {
 public:
     Maze(rng::Random &random, size_t size, float bridgePercent);
+    // Rebuilds a saved maze, walls[x*size + y] belongs to cell (x, y)
+    Maze(size_t size, const std::vector<Direction> &walls);
 
+    size_t getSize() const;
     const MazeNode &getNode(const glm::ivec2 &pos) const;
+    bool isInside(const glm::ivec2 &pos) const;
+
+    // Walks the cells crossed by the ray (DDA), dir has to be normalized
+    MazeRayHit raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const;
+    bool hasLineOfSight(const glm::vec2 &from, const glm::vec2 &to) const;
 
 protected:
-    rng::Random &m_random;
+    rng::Random *m_random;      // Generation only, null for rebuilt mazes
     Grid<MazeNode> m_nodes;
 
     Direction m_getRngDirection(const glm::ivec2 &pos, bool nextShouldBeEmpty);
@@ -0,0 +1,174 @@
+#include "net.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+using namespace shrekrooms::net;
+
+
+#ifdef _WIN32
+static void initWinsock() {
+    // Started once for the whole process, stopped at exit
+    static struct WinsockInit {
+        WinsockInit() {
+            WSADATA data;
+            if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+                throw shrekrooms::error { "net.cpp", "initWinsock", "Failed to start Winsock" };
+        }
+        ~WinsockInit() {
+            WSACleanup();
+        }
+    } init;
+}
+
+static int getLastError() {
+    return WSAGetLastError();
+}
+
+static bool isWouldBlock(int err) {
+    return err == WSAEWOULDBLOCK;
+}
+
+static void closeHandle(UdpSocket::Handle handle) {
+    closesocket(static_cast<SOCKET>(handle));
+}
+#else
+static void initWinsock() { }
+
+static int getLastError() {
+    return errno;
+}
+
+static bool isWouldBlock(int err) {
+    return err == EWOULDBLOCK || err == EAGAIN;
+}
+
+static void closeHandle(UdpSocket::Handle handle) {
+    close(handle);
+}
+#endif
+
+static sockaddr_in toSockaddr(const Address &address) {
+    sockaddr_in res {};
+    res.sin_family = AF_INET;
+    res.sin_addr.s_addr = htonl(address.host);
+    res.sin_port = htons(address.port);
+    return res;
+}
+
+
+/*
+ * struct shrekrooms::net::Address
+*/
+
+bool Address::operator ==(const Address &other) const {
+    return host == other.host && port == other.port;
+}
+
+bool Address::operator !=(const Address &other) const {
+    return !(*this == other);
+}
+
+uint64_t Address::getKey() const {
+    return (static_cast<uint64_t>(host) << 16) | port;
+}
+
+Address Address::s_loopback(uint16_t port) {
+    return { INADDR_LOOPBACK, port };
+}
+
+
+/*
+ * class shrekrooms::net::UdpSocket
+*/
+
+UdpSocket::UdpSocket(uint16_t port) {
+    initWinsock();
+
+#ifdef _WIN32
+    const SOCKET handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID_SOCKET)
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::UdpSocket", "Failed to create a socket" };
+    m_handle = static_cast<Handle>(handle);
+#else
+    m_handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_handle < 0)
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::UdpSocket", "Failed to create a socket" };
+#endif
+
+    const sockaddr_in addr = toSockaddr(Address::s_loopback(port));
+    if (bind(m_handle, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        closeHandle(m_handle);
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::UdpSocket", "Failed to bind port " + std::to_string(port) };
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    const bool isNonBlocking = (ioctlsocket(m_handle, FIONBIO, &nonBlocking) == 0);
+#else
+    const bool isNonBlocking = (fcntl(m_handle, F_SETFL, fcntl(m_handle, F_GETFL) | O_NONBLOCK) == 0);
+#endif
+    if (!isNonBlocking) {
+        closeHandle(m_handle);
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::UdpSocket", "Failed to make the socket non-blocking" };
+    }
+
+    sockaddr_in bound {};
+    socklen_t boundSize = sizeof(bound);
+    getsockname(m_handle, reinterpret_cast<sockaddr *>(&bound), &boundSize);
+    m_port = ntohs(bound.sin_port);
+}
+
+UdpSocket::~UdpSocket() {
+    closeHandle(m_handle);
+}
+
+uint16_t UdpSocket::getPort() const {
+    return m_port;
+}
+
+void UdpSocket::send(const Address &to, const std::vector<uint8_t> &data) {
+    if (data.size() > s_maxDatagram)
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::send", "Datagram of " + std::to_string(data.size()) + " bytes is too large" };
+
+    const sockaddr_in addr = toSockaddr(to);
+    const auto sent = sendto(m_handle, reinterpret_cast<const char *>(data.data()), static_cast<int>(data.size()), 0, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+    if (sent < 0 && !isWouldBlock(getLastError()))
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::send", "sendto failed with " + std::to_string(getLastError()) };
+}
+
+bool UdpSocket::receive(Address &from, std::vector<uint8_t> &data) {
+    data.resize(s_maxDatagram);
+    while (true) {
+        sockaddr_in addr {};
+        socklen_t addrSize = sizeof(addr);
+        const auto received = recvfrom(m_handle, reinterpret_cast<char *>(data.data()), static_cast<int>(data.size()), 0, reinterpret_cast<sockaddr *>(&addr), &addrSize);
+        if (received >= 0) {
+            data.resize(static_cast<size_t>(received));
+            from = { ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port) };
+            return true;
+        }
+
+        const int err = getLastError();
+        if (isWouldBlock(err)) {
+            data.clear();
+            return false;
+        }
+#ifdef _WIN32
+        // Reported for an earlier send to a closed port, not for this receive
+        if (err == WSAECONNRESET)
+            continue;
+#endif
+        throw error { "net.cpp", "shrekrooms::net::UdpSocket::receive", "recvfrom failed with " + std::to_string(err) };
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "defines.hpp"
+
+
+namespace shrekrooms::net {
+
+
+// IPv4 endpoint in host byte order
+struct Address {
+    uint32_t host;
+    uint16_t port;
+
+    bool operator ==(const Address &other) const;
+    bool operator !=(const Address &other) const;
+
+    uint64_t getKey() const;
+
+    static Address s_loopback(uint16_t port);
+
+};
+
+
+/*
+ * Non-blocking UDP socket bound to the loopback interface.
+ * POSIX sockets, Winsock on Windows
+*/
+class UdpSocket {
+public:
+#ifdef _WIN32
+    using Handle = uintptr_t;
+#else
+    using Handle = int;
+#endif
+
+    static constexpr size_t s_maxDatagram = 65507;
+
+    // Port 0 lets the system pick one
+    UdpSocket(uint16_t port = 0);
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator =(const UdpSocket &) = delete;
+
+    uint16_t getPort() const;
+
+    // Datagrams the system can't queue right now are dropped, like any other lost packet
+    void send(const Address &to, const std::vector<uint8_t> &data);
+    // False once nothing is waiting
+    bool receive(Address &from, std::vector<uint8_t> &data);
+
+protected:
+    Handle m_handle;
+    uint16_t m_port;
+
+};
+
+
+} // namespace shrekrooms::net
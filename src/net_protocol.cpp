@@ -0,0 +1,161 @@
+#include "net_protocol.hpp"
+
+using namespace shrekrooms;
+
+
+namespace {
+
+
+constexpr uint32_t magic = 0x504e5253;      // "SRNP"
+constexpr uint8_t version = 3;
+
+enum KeyBit : uint8_t {
+    Forward  = 1 << 0,
+    Backward = 1 << 1,
+    Left     = 1 << 2,
+    Right    = 1 << 3
+};
+
+enum FieldBit : uint8_t {
+    Pos    = 1 << 0,
+    Rot    = 1 << 1,
+    Sprite = 1 << 2
+};
+
+
+uint8_t getChangedFields(const EntitySnapshot *base, const EntitySnapshot &curr) {
+    if (!base)
+        return FieldBit::Pos | FieldBit::Rot | FieldBit::Sprite;
+
+    uint8_t fields = 0;
+    if (base->pos != curr.pos)
+        fields |= FieldBit::Pos;
+    if (base->rot != curr.rot)
+        fields |= FieldBit::Rot;
+    if (base->hasSprite != curr.hasSprite || (curr.hasSprite && base->sprite != curr.sprite))
+        fields |= FieldBit::Sprite;
+    return fields;
+}
+
+
+} // namespace
+
+
+void net::writeHeader(BlobWriter &writer, PacketType type) {
+    writer.write<uint32_t>(magic);
+    writer.write<uint8_t>(version);
+    writer.write<PacketType>(type);
+}
+
+bool net::readHeader(BlobReader &reader, PacketType &type) {
+    if (reader.getRemaining() < sizeof(uint32_t) + 2 * sizeof(uint8_t))
+        return false;
+    if (reader.read<uint32_t>() != magic || reader.read<uint8_t>() != version)
+        return false;
+
+    type = reader.read<PacketType>();
+    return type <= PacketType::Disconnect;
+}
+
+void net::writeInput(BlobWriter &writer, const PlayerInput &input) {
+    uint8_t keys = 0;
+    if (input.forward)  keys |= KeyBit::Forward;
+    if (input.backward) keys |= KeyBit::Backward;
+    if (input.left)     keys |= KeyBit::Left;
+    if (input.right)    keys |= KeyBit::Right;
+    writer.write<uint8_t>(keys);
+    writer.write<float>(input.mouseDeltaX);
+}
+
+PlayerInput net::readInput(BlobReader &reader) {
+    PlayerInput input;
+    const uint8_t keys = reader.read<uint8_t>();
+    input.forward  = keys & KeyBit::Forward;
+    input.backward = keys & KeyBit::Backward;
+    input.left     = keys & KeyBit::Left;
+    input.right    = keys & KeyBit::Right;
+    input.mouseDeltaX = reader.read<float>();
+    return input;
+}
+
+void net::writeSnapshotDelta(BlobWriter &writer, const SimSnapshot *base, const SimSnapshot &curr) {
+    static const std::vector<EntitySnapshot> noEntities;
+    const std::vector<EntitySnapshot> &baseEntities = base ? base->entities : noEntities;
+
+    // Both are sorted by id, so one merge pass splits them into removed and changed entities
+    std::vector<ecs::EntityID> removed;
+    std::vector<std::pair<const EntitySnapshot *, uint8_t>> changed;
+    auto it = baseEntities.begin();
+    for (const EntitySnapshot &entity : curr.entities) {
+        for (; it != baseEntities.end() && it->id < entity.id; it++)
+            removed.push_back(it->id);
+
+        const EntitySnapshot *prev = nullptr;
+        if (it != baseEntities.end() && it->id == entity.id)
+            prev = &*it++;
+
+        const uint8_t fields = getChangedFields(prev, entity);
+        if (fields)
+            changed.emplace_back(&entity, fields);
+    }
+    for (; it != baseEntities.end(); it++)
+        removed.push_back(it->id);
+
+    writer.write<uint32_t>(static_cast<uint32_t>(removed.size()));
+    for (ecs::EntityID id : removed)
+        writer.write<ecs::EntityID>(id);
+
+    writer.write<uint32_t>(static_cast<uint32_t>(changed.size()));
+    for (const auto &[entity, fields] : changed) {
+        writer.write<ecs::EntityID>(entity->id);
+        writer.write<uint8_t>(fields);
+        if (fields & FieldBit::Pos) {
+            writer.write<glm::ivec2>(entity->pos.chunk);
+            writer.write<glm::vec3>(entity->pos.local);
+        }
+        if (fields & FieldBit::Rot)
+            writer.write<float>(entity->rot);
+        if (fields & FieldBit::Sprite) {
+            writer.write<uint8_t>(entity->hasSprite);
+            writer.write<ecs::SpriteID>(entity->sprite);
+        }
+    }
+}
+
+void net::readSnapshotDelta(BlobReader &reader, const SimSnapshot *base, SimSnapshot &res) {
+    res.entities = base ? base->entities : std::vector<EntitySnapshot> {};
+
+    const uint32_t removedCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < removedCount; i++) {
+        const EntitySnapshot *entity = res.find(reader.read<ecs::EntityID>());
+        if (!entity)
+            throw error { "net_protocol.cpp", "shrekrooms::net::readSnapshotDelta", "Removed entity isn't in the base snapshot" };
+        res.entities.erase(res.entities.begin() + (entity - res.entities.data()));
+    }
+
+    const uint32_t changedCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < changedCount; i++) {
+        const ecs::EntityID id = reader.read<ecs::EntityID>();
+        const uint8_t fields = reader.read<uint8_t>();
+
+        auto it = std::lower_bound(res.entities.begin(), res.entities.end(), id, [](const EntitySnapshot &entity, ecs::EntityID id) {
+            return entity.id < id;
+        });
+        if (it == res.entities.end() || it->id != id) {
+            if (fields != (FieldBit::Pos | FieldBit::Rot | FieldBit::Sprite))
+                throw error { "net_protocol.cpp", "shrekrooms::net::readSnapshotDelta", "New entity is missing fields" };
+            it = res.entities.insert(it, { id, { }, 0.0f, false, ecs::SpriteID::Shrek });
+        }
+
+        if (fields & FieldBit::Pos) {
+            it->pos.chunk = reader.read<glm::ivec2>();
+            it->pos.local = reader.read<glm::vec3>();
+        }
+        if (fields & FieldBit::Rot)
+            it->rot = reader.read<float>();
+        if (fields & FieldBit::Sprite) {
+            it->hasSprite = reader.read<uint8_t>();
+            it->sprite = reader.read<ecs::SpriteID>();
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "defines.hpp"
+#include "blob.hpp"
+#include "player.hpp"
+#include "simulation.hpp"
+
+
+/*
+ * Datagrams exchanged between Server and Client, every one starts with the magic, version and PacketType.
+ *
+ * Connect     client -> server, repeated until a Welcome arrives
+ * Welcome     seed, entity id, server tick
+ * Input       acked snapshot tick, first input seq, count, inputs (the latest few, repeated against loss)
+ * Snapshot    tick, base tick, last applied input seq, fragment index, fragment count,
+ *             that fragment of the delta against the base snapshot
+ * Disconnect  client -> server
+*/
+namespace shrekrooms::net {
+
+
+enum class PacketType : uint8_t {
+    Connect,
+    Welcome,
+    Input,
+    Snapshot,
+    Disconnect
+
+};
+
+// In place of a tick for "no snapshot"
+constexpr uint64_t noTick = UINT64_MAX;
+
+
+void writeHeader(BlobWriter &writer, PacketType type);
+// False for datagrams of another protocol or version
+bool readHeader(BlobReader &reader, PacketType &type);
+
+void writeInput(BlobWriter &writer, const PlayerInput &input);
+PlayerInput readInput(BlobReader &reader);
+
+// Only entities that appeared, moved or disappeared since base are written, every one without a base
+void writeSnapshotDelta(BlobWriter &writer, const SimSnapshot *base, const SimSnapshot &curr);
+// base has to be the snapshot the delta was written against
+void readSnapshotDelta(BlobReader &reader, const SimSnapshot *base, SimSnapshot &res);
+
+
+} // namespace shrekrooms::net
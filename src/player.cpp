@@ -3,55 +3,55 @@
 using namespace shrekrooms;
 
 
-Player::Player(const gl::GLContext &glc, const glm::vec3 &pos, float cameraRot) : 
-    m_glc(glc), m_uniman(glc.getUniformManager()), m_pos(pos), m_cameraRot(cameraRot) { }
+/*
+ * struct shrekrooms::PlayerInput
+*/
 
-const glm::vec3 &Player::getPos() const {
-    return m_pos;
-}
-
-float Player::getCameraRot() const {
-    return m_cameraRot;
-}
+PlayerInput::PlayerInput() :
+    forward(false), backward(false), left(false), right(false), mouseDeltaX(0.0f) { }
 
-void Player::update(const World &world, float dt) {
-    if (!m_glc.isWindowFocused())
-        return;
 
-    glm::vec2 mousepos = m_glc.getCursorPos();
-    m_glc.setCursorPos({ 0.0f, 0.0f });
+ecs::EntityID shrekrooms::spawnPlayer(ecs::Registry &registry, const WorldPos &pos, float cameraRot, size_t inputIndex) {
+    return registry.create(
+        ecs::Transform { pos, cameraRot },
+        ecs::Velocity { { 0.0f, 0.0f } },
+        ecs::Collider { defines::player::radius, true },
+        ecs::Controller { inputIndex }
+    );
+}
 
-    m_cameraRot += defines::player::mouseSensitivity * mousepos.x * dt;
+void shrekrooms::updatePlayers(ecs::Registry &registry, const std::vector<PlayerInput> &inputs, float dt) {
+    registry.each<ecs::Transform, ecs::Velocity, ecs::Controller>([&inputs, dt](ecs::EntityID, ecs::Transform &transform, ecs::Velocity &velocity, const ecs::Controller &controller) {
+        const PlayerInput input = (controller.inputIndex < inputs.size()) ? inputs[controller.inputIndex] : PlayerInput {};
+
+        // dt is the fixed tick length, so the turn no longer depends on the frame rate
+        transform.rot += defines::player::mouseSensitivity * input.mouseDeltaX * dt;
+
+        glm::vec3 forw = getForward(transform.rot);
+        glm::vec3 right = glm::normalize(glm::cross(forw, defines::globalUp));
+
+        glm::vec3 dPos = { 0.0f, 0.0f, 0.0f };
+        if (input.forward)
+            dPos += forw;
+        if (input.backward)
+            dPos -= forw;
+        if (input.left)
+            dPos -= right;
+        if (input.right)
+            dPos += right;
+
+        velocity.vel = { 0.0f, 0.0f };
+        if (glm::length(dPos) > 0.1f) {
+            dPos = glm::normalize(dPos);
+            velocity.vel = defines::player::walkSpeed * glm::vec2 { dPos.x, dPos.z };
+        }
+    });
+}
 
-    glm::vec3 forw = {
-        glm::cos(m_cameraRot),
+glm::vec3 shrekrooms::getForward(float rot) {
+    return {
+        glm::cos(rot),
         0.0f,
-        glm::sin(m_cameraRot)
+        glm::sin(rot)
     };
-    glm::vec3 right = glm::normalize(glm::cross(forw, defines::globalUp));
-
-    glm::vec3 dPos = { 0.0f, 0.0f, 0.0f };
-    if (m_glc.isKeyPressed(defines::controls::keyForward))
-        dPos += forw;
-    if (m_glc.isKeyPressed(defines::controls::keyBackward))
-        dPos -= forw;
-    if (m_glc.isKeyPressed(defines::controls::keyLeft))
-        dPos -= right;
-    if (m_glc.isKeyPressed(defines::controls::keyRight))
-        dPos += right;
-
-    if (glm::length(dPos) > 0.1f) {
-        dPos = glm::normalize(dPos);
-        m_pos += defines::player::walkSpeed * dPos * dt;
-    }
-
-    Collision coll = world.getCollision({ m_pos.x, m_pos.z }, defines::player::radius);
-    if (coll.isColliding)
-        m_pos += glm::vec3 { coll.cancelVector.x, 0.0f, coll.cancelVector.y };
-
-    m_glc.enableShader();
-    glm::mat4 view = glm::lookAt(m_pos, m_pos + forw, defines::globalUp);
-    m_uniman.setViewMatrix(view);
-
-    m_uniman.setViewPos(m_pos);
 }
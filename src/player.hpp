@@ -1,29 +1,29 @@
 #pragma once
 
 #include "defines.hpp"
-#include "glc.hpp"
-#include "world.hpp"
+#include "ecs.hpp"
 
 
 namespace shrekrooms {
 
 
-class Player {
-public:
-    Player(const gl::GLContext &glc, const glm::vec3 &pos, float cameraRot);
+// Controls sampled on the render thread and consumed by a simulation tick
+struct PlayerInput {
+    bool forward, backward, left, right;
+    float mouseDeltaX;      // Accumulated since the previous tick
 
-    const glm::vec3 &getPos() const;
-    float getCameraRot() const;
+    PlayerInput();
 
-    void update(const World &world, float dt);
+};
 
-protected:
-    const gl::GLContext &m_glc;
-    const UniformManager &m_uniman;
-    glm::vec3 m_pos;
-    float m_cameraRot;
 
-};
+ecs::EntityID spawnPlayer(ecs::Registry &registry, const WorldPos &pos, float cameraRot, size_t inputIndex);
+
+// Turns every Controller's input into its heading and velocity, movement itself is applied later.
+// Controllers without an input in inputs stand still
+void updatePlayers(ecs::Registry &registry, const std::vector<PlayerInput> &inputs, float dt);
+
+glm::vec3 getForward(float rot);
 
 
 } // namespace shrekrooms
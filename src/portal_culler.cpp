@@ -0,0 +1,124 @@
+#include "portal_culler.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * class shrekrooms::PortalCuller
+*/
+
+PortalCuller::PortalCuller(const maze::Maze &maze) :
+        m_maze(maze), m_isInside(false) { }
+
+void PortalCuller::update(const WorldPos &viewOrigin, const glm::vec2 &forward, float tanHalfFov, const Frustum &frustum) {
+    m_cells.clear();
+    m_stack.clear();
+
+    m_isInside = m_maze.isInside(viewOrigin.chunk);
+    if (!m_isInside)
+        return;
+
+    // Slightly wider than the screen, so cells seen along its edges aren't lost to rounding
+    const glm::vec2 side = 1.01f * tanHalfFov * glm::vec2 { -forward.y, forward.x };
+    m_enter(viewOrigin.chunk, { forward - side, forward + side });
+
+    const float halfSize = 0.5f * defines::world::chunkSize;
+    while (!m_stack.empty()) {
+        const Visit visit = m_stack.back();
+        m_stack.pop_back();
+
+        const glm::vec3 center3 = WorldPos { visit.cell, { 0.0f, 0.0f, 0.0f } }.relativeTo(viewOrigin);
+        const glm::vec2 center { center3.x, center3.z };
+        const maze::MazeNode &node = m_maze.getNode(visit.cell);
+
+        for (maze::Direction dir : maze::allDirections) {
+            if (node.hasWall(dir))
+                continue;
+
+            const glm::ivec2 next = visit.cell + maze::getDirectionVector(dir);
+            if (!m_maze.isInside(next))
+                continue;
+            if (frustum.testBox(ChunkTable::s_getBox(next, next, viewOrigin)) == Frustum::Test::Outside)
+                continue;
+
+            const glm::vec2 normal = static_cast<glm::vec2>(maze::getDirectionVector(dir));
+            const glm::vec2 portalCenter = center + halfSize*normal;
+            const float dist = glm::dot(portalCenter, normal);
+
+            // Portals are only passed away from the viewer, which also keeps the walk from turning back
+            Wedge wedge = visit.wedge;
+            if (dist < s_portalMargin) {
+                if (visit.cell != viewOrigin.chunk)
+                    continue;
+            }
+            else {
+                const glm::vec2 tangent { normal.y, normal.x };
+                if (!s_clipPortal(wedge, portalCenter - halfSize*tangent, portalCenter + halfSize*tangent))
+                    continue;
+            }
+            m_enter(next, wedge);
+        }
+    }
+}
+
+bool PortalCuller::isVisible(const glm::ivec2 &chunkPos) const {
+    return !m_isInside || m_cells.count(getChunkKey(chunkPos));
+}
+
+size_t PortalCuller::getVisibleCount() const {
+    return m_cells.size();
+}
+
+float PortalCuller::s_cross(const glm::vec2 &a, const glm::vec2 &b) {
+    return a.x*b.y - a.y*b.x;
+}
+
+bool PortalCuller::s_contains(const Wedge &outer, const Wedge &inner) {
+    return s_cross(outer.from, inner.from) >= 0.0f && s_cross(inner.to, outer.to) >= 0.0f;
+}
+
+PortalCuller::Wedge PortalCuller::s_merge(const Wedge &a, const Wedge &b) {
+    // Both lie in the view wedge, so the union is bounded by the outermost edges
+    return {
+        s_cross(a.from, b.from) >= 0.0f ? a.from : b.from,
+        s_cross(a.to, b.to) >= 0.0f ? b.to : a.to
+    };
+}
+
+bool PortalCuller::s_clipPortal(Wedge &wedge, glm::vec2 a, glm::vec2 b) {
+    for (int edge = 0; edge < 2; edge++) {
+        // Signed distance from the wedge's edge, positive is inside
+        const auto side = [&](const glm::vec2 &p) {
+            return edge == 0 ? s_cross(wedge.from, p) : s_cross(p, wedge.to);
+        };
+
+        const float da = side(a);
+        const float db = side(b);
+        if (da < 0.0f && db < 0.0f)
+            return false;
+        if (da < 0.0f)
+            a += (b - a) * (da / (da - db));
+        else if (db < 0.0f)
+            b += (a - b) * (db / (db - da));
+    }
+
+    if (s_cross(a, b) < 0.0f)
+        std::swap(a, b);
+    // Seen edge-on
+    if (s_cross(a, b) <= defines::epsilon * glm::length(a) * glm::length(b))
+        return false;
+
+    wedge = { a, b };
+    return true;
+}
+
+void PortalCuller::m_enter(const glm::ivec2 &cell, const Wedge &wedge) {
+    auto [it, isNew] = m_cells.try_emplace(getChunkKey(cell), wedge);
+    if (!isNew) {
+        // Cells reached along several paths are walked again only with a wider wedge
+        if (s_contains(it->second, wedge))
+            return;
+        it->second = s_merge(it->second, wedge);
+    }
+    m_stack.push_back({ cell, it->second });
+}
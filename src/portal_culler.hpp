@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.hpp"
+#include "maze.hpp"
+#include "world.hpp"
+#include "frustum.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Cells visible from the viewer through the maze: starting in the viewer's cell,
+ * the horizontal view wedge is narrowed by every open edge (portal) it passes,
+ * and a cell is only entered while some of the wedge is left.
+ * The maze is a single floor and the view never pitches, so 2D is exact
+*/
+class PortalCuller {
+public:
+    PortalCuller(const maze::Maze &maze);
+
+    // forward is on the xz plane, tanHalfFov is the tangent of half the horizontal field of view
+    void update(const WorldPos &viewOrigin, const glm::vec2 &forward, float tanHalfFov, const Frustum &frustum);
+
+    // Everything is visible from outside the maze
+    bool isVisible(const glm::ivec2 &chunkPos) const;
+    size_t getVisibleCount() const;
+
+protected:
+    // Directions from the viewer, counter-clockwise from 'from' to 'to', less than half a turn wide
+    struct Wedge {
+        glm::vec2 from, to;
+    };
+
+    struct Visit {
+        glm::ivec2 cell;
+        Wedge wedge;
+    };
+
+    // Viewers closer to a portal than this see through it whole
+    static constexpr float s_portalMargin = 0.01f;
+
+    const maze::Maze &m_maze;
+    bool m_isInside;
+    // Widest wedge each visible cell was entered with
+    std::unordered_map<uint64_t, Wedge> m_cells;
+    std::vector<Visit> m_stack;
+
+    static float s_cross(const glm::vec2 &a, const glm::vec2 &b);
+    static bool s_contains(const Wedge &outer, const Wedge &inner);
+    static Wedge s_merge(const Wedge &a, const Wedge &b);
+    // Narrows the wedge to the part of the portal [a; b] inside it, false if none is
+    static bool s_clipPortal(Wedge &wedge, glm::vec2 a, glm::vec2 b);
+
+    void m_enter(const glm::ivec2 &cell, const Wedge &wedge);
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,324 @@
+#include "renderer.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * class shrekrooms::Renderer
+*/
+
+const WorldMesh::ChunkMeshes Renderer::s_chunkMeshes {
+    MeshManager::Mesh::ChunkFloor,
+    MeshManager::Mesh::ChunkWallX,
+    MeshManager::Mesh::ChunkWallXNeg,
+    MeshManager::Mesh::ChunkWallZ,
+    MeshManager::Mesh::ChunkWallZNeg
+};
+
+Renderer::Renderer(gl::GLContext &glc, const World &world) :
+        m_glc(glc), m_uniman(glc.getUniformManager()), m_meshman(glc.getMeshManager()), m_maze(world.getMaze()), m_streamCenter(-1), m_portals(m_maze), m_stats(), m_instanceAnchor(0) {
+    setFog(defines::world::fogStart, defines::world::fogDensity);
+
+    for (size_t mesh = 0; mesh < ChunkTable::s_meshCount; mesh++)
+        m_meshman.initInstanceBuffer(s_chunkMeshes[mesh], m_chunkInstances[mesh]);
+
+    const int size = static_cast<int>(m_maze.getSize());
+    if (defines::world::bakeWorldMesh)
+        m_worldMesh = std::make_unique<WorldMesh>(m_meshman, m_glc.getStateCache(), s_chunkMeshes, glm::ivec2 { size/2, size/2 }, s_getMaxRegions(size));
+
+    if (defines::world::chunkStreamRadius > 0)
+        return;
+
+    m_chunks.reserve(size*size);
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++)
+            m_pushChunk({ x, y });
+    }
+    m_updateChunkGeometry({ size/2, size/2 });
+}
+
+void Renderer::update(const WorldPos &viewPos) {
+    if (defines::world::chunkStreamRadius <= 0)
+        return;
+
+    const glm::ivec2 &center = viewPos.chunk;
+    if (center != m_streamCenter)
+        m_streamChunks(center);
+}
+
+void Renderer::setView(const EntitySnapshot &viewer) {
+    m_viewOrigin = viewer.pos;
+
+    m_glc.enableShader();
+    glm::mat4 view = glm::lookAt(glm::vec3 { 0.0f, 0.0f, 0.0f }, getForward(viewer.rot), defines::globalUp);
+    m_uniman.setViewMatrix(view);
+    m_frustum = Frustum::s_fromMatrix(m_glc.getProjectionMatrix() * view);
+
+    if (defines::world::portalCulling) {
+        const glm::vec3 forward = getForward(viewer.rot);
+        // The projection's x scale is 1 / tan(horizontal fov / 2)
+        const float tanHalfFov = 1.0f / m_glc.getProjectionMatrix()[0][0];
+        m_portals.update(m_viewOrigin, glm::normalize(glm::vec2 { forward.x, forward.z }), tanHalfFov, m_frustum);
+    }
+
+    m_uniman.setViewPos({ 0.0f, 0.0f, 0.0f });
+}
+
+void Renderer::drawWorld() {
+    m_glc.enableShader();
+
+    if (m_worldMesh) {
+        m_worldMesh->cull([this](const glm::ivec2 &chunkMin, const glm::ivec2 &chunkMax) {
+            const Box box = ChunkTable::s_getBox(chunkMin, chunkMax, m_viewOrigin);
+            if (m_isFogged(box) || m_frustum.testBox(box) == Frustum::Test::Outside)
+                return false;
+            for (int x = chunkMin.x; x <= chunkMax.x; x++) {
+                for (int y = chunkMin.y; y <= chunkMax.y; y++) {
+                    if (!m_isOccluded({ x, y }))
+                        return true;
+                }
+            }
+            return false;
+        });
+        m_stats.chunksVisible = m_worldMesh->getVisibleChunkCount();
+        m_stats.chunksCulled = m_chunks.size() - m_stats.chunksVisible;
+        m_stats.chunksOccluded = 0;
+        m_stats.blocksCulled = m_worldMesh->getCulledRegionCount();
+
+        const glm::vec3 anchor = WorldPos { m_worldMesh->getAnchor(), { 0.0f, 0.0f, 0.0f } }.relativeTo(m_viewOrigin);
+        m_uniman.setTranslateMatrix(glm::translate(defines::mat4identity, anchor));
+        m_worldMesh->draw(m_uniman);
+        return;
+    }
+
+    m_cullInstances();
+
+    const glm::vec3 anchor = WorldPos { m_instanceAnchor, { 0.0f, 0.0f, 0.0f } }.relativeTo(m_viewOrigin);
+    m_uniman.setTranslateMatrix(glm::translate(defines::mat4identity, anchor));
+
+    for (size_t mesh = 0; mesh < ChunkTable::s_meshCount; mesh++)
+        m_meshman.renderMeshInstanced(s_chunkMeshes[mesh], m_chunkInstances[mesh]);
+}
+
+void Renderer::drawSprites(const SimSnapshot &snapshot) {
+    // Bounding sphere of the Shrek billboard, the only sprite, which stands on the floor below pos
+    const float spriteRadius = 0.5f * glm::length(glm::vec2 { defines::shrek::width, defines::shrek::height });
+    const glm::vec3 spriteCenter { 0.0f, 0.5f * (defines::shrek::height - defines::world::chunkHeight), 0.0f };
+
+    m_stats.entitiesVisible = 0;
+    m_stats.entitiesCulled = 0;
+
+    for (const EntitySnapshot &entity : snapshot.entities) {
+        if (!entity.hasSprite)
+            continue;
+
+        const glm::vec3 pos = entity.pos.relativeTo(m_viewOrigin);
+        if (!m_frustum.isSphereVisible(pos + spriteCenter, spriteRadius)) {
+            m_stats.entitiesCulled++;
+            continue;
+        }
+        m_stats.entitiesVisible++;
+
+        // Position based
+        float angle = glm::acos(glm::dot(glm::normalize(pos), { 1.0f, 0.0f, 0.0f }));
+        if (pos.z < 0) angle = -angle;
+        glm::mat4 rotMat = glm::rotate(defines::mat4identity, -angle, defines::globalUp);
+        m_uniman.setRotateMatrix(rotMat);
+
+        // View direction based
+        // glm::mat4 rotMat = glm::rotate(defines::mat4identity, -viewer.rot, defines::globalUp);
+
+        // m_uniman.setRotateMatrix(rotMat);
+
+        glm::mat4 transMat = glm::translate(defines::mat4identity, pos);
+
+        m_uniman.setTranslateMatrix(transMat);
+        m_meshman.renderMesh(s_getSpriteMesh(entity.sprite));
+    }
+    m_uniman.setRotateMatrix(defines::mat4identity);
+}
+
+const Renderer::Stats &Renderer::getStats() const {
+    return m_stats;
+}
+
+void Renderer::setFog(float start, float density) {
+    m_fogStart = start;
+    m_fogDensity = density;
+    m_viewDistance = s_getFogDistance(start, density);
+
+    m_glc.setFarPlane(m_viewDistance);
+    m_uniman.setFogStart(start);
+    m_uniman.setFogDensity(density);
+}
+
+float Renderer::getFogStart() const {
+    return m_fogStart;
+}
+
+float Renderer::getFogDensity() const {
+    return m_fogDensity;
+}
+
+float Renderer::getViewDistance() const {
+    return m_viewDistance;
+}
+
+MeshManager::Mesh Renderer::s_getSpriteMesh(ecs::SpriteID sprite) {
+    switch (sprite) {
+    case ecs::SpriteID::Shrek: return MeshManager::Mesh::Shrek;
+    }
+    return MeshManager::Mesh::Null;
+}
+
+float Renderer::s_getFogDistance(float start, float density) {
+    // The shader keeps 2t - t^2 of the colour, t = exp(-(dist - start) * density)
+    const float t = 1.0f - std::sqrt(1.0f - defines::world::fogCutoff);
+    return start - std::log(t) / density;
+}
+
+size_t Renderer::s_getMaxRegions(size_t mazeSize) {
+    const size_t regionSize = defines::world::bakeRegionSize;
+    size_t regionsWidth = (mazeSize + regionSize - 1) / regionSize;
+
+    // A window of w chunks touches at most ceil((w - 1) / regionSize) + 1 regions per side
+    if (defines::world::chunkStreamRadius > 0) {
+        const size_t windowWidth = 2*(defines::world::chunkStreamRadius + defines::world::chunkStreamHysteresis) + 1;
+        regionsWidth = std::min(regionsWidth, (windowWidth + regionSize - 2) / regionSize + 1);
+    }
+    return regionsWidth * regionsWidth;
+}
+
+void Renderer::m_pushChunk(const glm::ivec2 &chunkPos) {
+    m_chunks.push(chunkPos, ChunkTable::s_getMeshMask(chunkPos, m_maze.getNode(chunkPos)));
+    if (m_worldMesh)
+        m_worldMesh->markDirty(chunkPos);
+}
+
+void Renderer::m_removeChunk(size_t index) {
+    if (m_worldMesh)
+        m_worldMesh->markDirty(m_chunks.chunkPos[index]);
+    m_chunks.remove(index);
+}
+
+void Renderer::m_updateChunkGeometry(const glm::ivec2 &anchor) {
+    if (m_worldMesh)
+        m_worldMesh->update(m_chunks);
+    else
+        m_buildInstances(anchor);
+}
+
+void Renderer::m_streamChunks(const glm::ivec2 &center) {
+    // Chunks load within the radius but only unload past radius + hysteresis,
+    // so walking back and forth over a chunk border doesn't reload anything
+    const int loadRadius = defines::world::chunkStreamRadius;
+    const int unloadRadius = loadRadius + defines::world::chunkStreamHysteresis;
+    const int windowWidth = 2*loadRadius + 1;
+
+    m_streamCenter = center;
+
+    std::vector<bool> loaded(windowWidth*windowWidth, false);
+    // Backwards, so the chunk moved in by remove() has already been visited
+    for (size_t i = m_chunks.size(); i-- > 0; ) {
+        const glm::ivec2 diff = m_chunks.chunkPos[i] - center;
+        const int dist = std::max(std::abs(diff.x), std::abs(diff.y));
+        if (dist > unloadRadius)
+            m_removeChunk(i);
+        else if (dist <= loadRadius)
+            loaded[(diff.x + loadRadius) * windowWidth + (diff.y + loadRadius)] = true;
+    }
+
+    for (int x = -loadRadius; x <= loadRadius; x++) {
+        for (int y = -loadRadius; y <= loadRadius; y++) {
+            glm::ivec2 chunkPos = center + glm::ivec2 { x, y };
+            if (loaded[(x + loadRadius) * windowWidth + (y + loadRadius)] || !m_maze.isInside(chunkPos))
+                continue;
+            m_pushChunk(chunkPos);
+        }
+    }
+    m_updateChunkGeometry(center);
+}
+
+void Renderer::m_buildInstances(const glm::ivec2 &anchor) {
+    // Offsets stay small around the anchor, which keeps them precise however far out it is
+    m_instanceAnchor = anchor;
+
+    const int blockSize = defines::world::cullBlockSize;
+    std::unordered_map<uint64_t, size_t> blockIds;
+    m_cullBlocks.clear();
+    m_chunkOffsets.resize(m_chunks.size());
+
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        const glm::ivec2 &chunkPos = m_chunks.chunkPos[i];
+        const glm::vec2 nudge = ChunkTable::s_getNudge(chunkPos);
+        m_chunkOffsets[i] = WorldPos { chunkPos, { nudge.x, 0.0f, nudge.y } }.relativeTo({ anchor, { 0.0f, 0.0f, 0.0f } });
+
+        const glm::ivec2 block = static_cast<glm::ivec2>(glm::floor(static_cast<glm::vec2>(chunkPos) / static_cast<float>(blockSize)));
+        auto it = blockIds.try_emplace(getChunkKey(block), m_cullBlocks.size()).first;
+        if (it->second == m_cullBlocks.size())
+            m_cullBlocks.push_back({ block, {} });
+        m_cullBlocks[it->second].chunkIds.push_back(i);
+    }
+}
+
+void Renderer::m_addVisibleChunk(uint32_t chunkId) {
+    const ChunkTable::MeshMask mask = m_chunks.meshMasks[chunkId];
+    for (size_t mesh = 0; mesh < ChunkTable::s_meshCount; mesh++) {
+        if (mask & (1 << mesh))
+            m_visibleOffsets[mesh].push_back(m_chunkOffsets[chunkId]);
+    }
+}
+
+bool Renderer::m_isOccluded(const glm::ivec2 &chunkPos) const {
+    return defines::world::portalCulling && !m_portals.isVisible(chunkPos);
+}
+
+bool Renderer::m_isFogged(const Box &box) const {
+    // The viewer is at the origin
+    const glm::vec3 closest = glm::clamp(glm::vec3 { 0.0f, 0.0f, 0.0f }, box.min, box.max);
+    return glm::dot(closest, closest) > m_viewDistance * m_viewDistance;
+}
+
+void Renderer::m_cullInstances() {
+    const int blockSize = defines::world::cullBlockSize;
+
+    for (std::vector<glm::vec3> &offsets : m_visibleOffsets)
+        offsets.clear();
+    m_stats.chunksVisible = 0;
+    m_stats.chunksCulled = 0;
+    m_stats.chunksOccluded = 0;
+    m_stats.blocksCulled = 0;
+
+    for (const CullBlock &block : m_cullBlocks) {
+        const glm::ivec2 chunkMin = blockSize * block.block;
+        const Box blockBox = ChunkTable::s_getBox(chunkMin, chunkMin + (blockSize - 1), m_viewOrigin);
+        const Frustum::Test test = m_isFogged(blockBox) ? Frustum::Test::Outside : m_frustum.testBox(blockBox);
+
+        if (test == Frustum::Test::Outside) {
+            m_stats.chunksCulled += block.chunkIds.size();
+            m_stats.blocksCulled++;
+            continue;
+        }
+
+        for (uint32_t chunkId : block.chunkIds) {
+            const glm::ivec2 &chunkPos = m_chunks.chunkPos[chunkId];
+            const Box box = ChunkTable::s_getBox(chunkPos, chunkPos, m_viewOrigin);
+            // Chunks of a block wholly inside the frustum need no test of their own
+            const bool isOutside = test == Frustum::Test::Intersecting && m_frustum.testBox(box) == Frustum::Test::Outside;
+            if (isOutside || m_isFogged(box)) {
+                m_stats.chunksCulled++;
+                continue;
+            }
+            if (m_isOccluded(chunkPos)) {
+                m_stats.chunksCulled++;
+                m_stats.chunksOccluded++;
+                continue;
+            }
+            m_stats.chunksVisible++;
+            m_addVisibleChunk(chunkId);
+        }
+    }
+
+    for (size_t mesh = 0; mesh < ChunkTable::s_meshCount; mesh++)
+        MeshManager::s_setInstanceOffsets(m_chunkInstances[mesh], m_visibleOffsets[mesh]);
+}
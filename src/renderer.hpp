@@ -0,0 +1,102 @@
+#pragma once
+
+#include "defines.hpp"
+#include "glc.hpp"
+#include "world.hpp"
+#include "world_mesh.hpp"
+#include "frustum.hpp"
+#include "portal_culler.hpp"
+#include "simulation.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Everything that draws the game. Reads simulation state, never changes it,
+ * so the simulation builds and runs without it.
+ * Drawn relative to the viewer: the camera sits at the origin and every translation
+ * is a small offset from it, so precision doesn't depend on where in the world it is
+*/
+class Renderer {
+public:
+    // Counts of the last drawn frame
+    struct Stats {
+        size_t chunksVisible;
+        size_t chunksCulled;
+        size_t chunksOccluded;  // In the frustum but behind walls, part of chunksCulled
+        size_t blocksCulled;    // Chunk blocks, or baked regions, rejected as a whole
+        size_t entitiesVisible;
+        size_t entitiesCulled;
+    };
+
+    Renderer(gl::GLContext &glc, const World &world);
+
+    // Loads and unloads chunks around the viewer when streaming is enabled
+    void update(const WorldPos &viewPos);
+
+    // Everything after is drawn around this view, only what's in its frustum is drawn
+    void setView(const EntitySnapshot &viewer);
+    void drawWorld();
+    // Billboards face the viewer
+    void drawSprites(const SimSnapshot &snapshot);
+
+    const Stats &getStats() const;
+
+    // Chunks past the distance where fog covers everything are skipped, and the far plane is moved there
+    void setFog(float start, float density);
+    float getFogStart() const;
+    float getFogDensity() const;
+    float getViewDistance() const;
+
+protected:
+    // Resident chunks grouped by position, so most can be culled a block at a time
+    struct CullBlock {
+        glm::ivec2 block;
+        std::vector<uint32_t> chunkIds;
+    };
+
+    static const WorldMesh::ChunkMeshes s_chunkMeshes;
+    static MeshManager::Mesh s_getSpriteMesh(ecs::SpriteID sprite);
+    // Regions that can be resident at once
+    static size_t s_getMaxRegions(size_t mazeSize);
+    // Distance where the fog is within defines::world::fogCutoff of the fog colour
+    static float s_getFogDistance(float start, float density);
+
+    gl::GLContext &m_glc;
+    const UniformManager &m_uniman;
+    const MeshManager &m_meshman;
+    const maze::Maze &m_maze;
+    ChunkTable m_chunks;    // Resident chunks only
+    glm::ivec2 m_streamCenter;
+    WorldPos m_viewOrigin;
+    Frustum m_frustum;
+    PortalCuller m_portals;
+    Stats m_stats;
+    float m_fogStart, m_fogDensity;
+    float m_viewDistance;
+    // One draw per chunk mesh, offsets are relative to the anchor chunk
+    std::array<gl::InstanceBuffer, ChunkTable::s_meshCount> m_chunkInstances;
+    glm::ivec2 m_instanceAnchor;
+    std::vector<glm::vec3> m_chunkOffsets;  // From the anchor, per resident chunk
+    std::vector<CullBlock> m_cullBlocks;
+    std::array<std::vector<glm::vec3>, ChunkTable::s_meshCount> m_visibleOffsets;
+    std::unique_ptr<WorldMesh> m_worldMesh;     // Used instead of the instances when baking is enabled
+
+    void m_pushChunk(const glm::ivec2 &chunkPos);
+    void m_removeChunk(size_t index);
+    // Rebuilds whichever of the instances or the baked mesh is used
+    void m_updateChunkGeometry(const glm::ivec2 &anchor);
+
+    void m_streamChunks(const glm::ivec2 &center);
+    void m_buildInstances(const glm::ivec2 &anchor);
+    void m_addVisibleChunk(uint32_t chunkId);
+    bool m_isOccluded(const glm::ivec2 &chunkPos) const;
+    bool m_isFogged(const Box &box) const;
+    // Uploads the offsets of the chunks in the frustum
+    void m_cullInstances();
+
+};
+
+
+} // namespace shrekrooms
@@ -8,7 +8,14 @@ using namespace shrekrooms::rng;
 */
 
 Random::Random() :
-    m_device(), m_engine(m_device()) { }
+    Random(std::random_device {}()) { }
+
+Random::Random(Seed seed) :
+    m_seed(seed), m_engine(seed) { }
+
+Random::Seed shrekrooms::rng::Random::getSeed() const {
+    return m_seed;
+}
 
 RandomEngine &shrekrooms::rng::Random::getEngine() {
     return m_engine;
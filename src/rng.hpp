@@ -40,15 +40,19 @@ using RandFloat = RandVal<float>;
 
 class Random {
 public:
+    using Seed = RandomEngine::result_type;
+
     Random();
+    Random(Seed seed);
 
+    Seed getSeed() const;
     RandomEngine &getEngine();
 
     RandInt getRandInt(RandInt::Val lo, RandInt::Val hi);
     RandFloat getRandFloat(RandFloat::Val lo, RandFloat::Val hi);
 
 protected:
-    std::random_device m_device;
+    Seed m_seed;
     RandomEngine m_engine;
 
 };
@@ -0,0 +1,219 @@
+#include "save_state.hpp"
+
+using namespace shrekrooms;
+
+
+namespace {
+
+
+constexpr uint32_t magic = 0x53535253;      // "SRSS"
+constexpr uint32_t version = 2;
+
+
+void writeComponent(BlobWriter &writer, const ecs::Transform &transform) {
+    writer.write(transform.pos.chunk);
+    writer.write(transform.pos.local);
+    writer.write(transform.rot);
+}
+
+void writeComponent(BlobWriter &writer, const ecs::Velocity &velocity) {
+    writer.write(velocity.vel);
+}
+
+void writeComponent(BlobWriter &writer, const ecs::Collider &collider) {
+    writer.write(collider.radius);
+    writer.write<uint8_t>(collider.solid);
+}
+
+void writeComponent(BlobWriter &writer, const ecs::Pursuer &pursuer) {
+    writer.write(pursuer.target);
+    writer.write(pursuer.nextPos.chunk);
+    writer.write(pursuer.nextPos.local);
+    writer.write(pursuer.mazePos);
+    writer.write(static_cast<uint32_t>(pursuer.path.size()));
+    writer.writeBytes(pursuer.path.data(), pursuer.path.size() * sizeof(glm::ivec2));
+}
+
+void writeComponent(BlobWriter &writer, const ecs::Controller &controller) {
+    writer.write(static_cast<uint32_t>(controller.inputIndex));
+}
+
+void writeComponent(BlobWriter &writer, const ecs::Sprite &sprite) {
+    writer.write(sprite.id);
+}
+
+void readComponent(BlobReader &reader, ecs::Transform &transform) {
+    transform.pos.chunk = reader.read<glm::ivec2>();
+    transform.pos.local = reader.read<glm::vec3>();
+    transform.rot = reader.read<float>();
+}
+
+void readComponent(BlobReader &reader, ecs::Velocity &velocity) {
+    velocity.vel = reader.read<glm::vec2>();
+}
+
+void readComponent(BlobReader &reader, ecs::Collider &collider) {
+    collider.radius = reader.read<float>();
+    collider.solid = reader.read<uint8_t>();
+}
+
+void readComponent(BlobReader &reader, ecs::Pursuer &pursuer) {
+    pursuer.target = reader.read<ecs::EntityID>();
+    pursuer.nextPos.chunk = reader.read<glm::ivec2>();
+    pursuer.nextPos.local = reader.read<glm::vec3>();
+    pursuer.mazePos = reader.read<glm::ivec2>();
+    const uint32_t pathSize = reader.read<uint32_t>();
+    if (pathSize > reader.getRemaining() / sizeof(glm::ivec2))
+        throw error { "save_state.cpp", "shrekrooms::save::readState", "Path is longer than the data" };
+    pursuer.path.resize(pathSize);
+    reader.readBytes(pursuer.path.data(), pathSize * sizeof(glm::ivec2));
+}
+
+void readComponent(BlobReader &reader, ecs::Controller &controller) {
+    controller.inputIndex = reader.read<uint32_t>();
+}
+
+void readComponent(BlobReader &reader, ecs::Sprite &sprite) {
+    sprite.id = reader.read<ecs::SpriteID>();
+}
+
+template <typename... _Ts>
+void writeComponents(BlobWriter &writer, const ecs::Registry &registry, ecs::EntityID id, ecs::ComponentMask mask, std::tuple<_Ts...> *) {
+    // In ComponentTypes order, get() throws for components outside mask
+    (((mask & ecs::componentBit<_Ts>) ? writeComponent(writer, registry.get<_Ts>(id)) : void()), ...);
+}
+
+template <typename... _Ts>
+void readComponents(BlobReader &reader, ecs::Registry &registry, ecs::EntityID id, ecs::ComponentMask mask, std::tuple<_Ts...> *) {
+    (((mask & ecs::componentBit<_Ts>) ? readComponent(reader, registry.get<_Ts>(id)) : void()), ...);
+}
+
+template <typename... _Ts>
+constexpr ecs::ComponentMask allComponents(std::tuple<_Ts...> *) {
+    return ecs::componentMask<_Ts...>;
+}
+
+BlobReader readHeader(const std::vector<uint8_t> &blob, const char *func) {
+    BlobReader reader { blob.data(), blob.size() };
+    if (reader.read<uint32_t>() != magic)
+        throw error { "save_state.cpp", func, "Not a saved state" };
+    if (reader.read<uint32_t>() != version)
+        throw error { "save_state.cpp", func, "Unsupported saved state version" };
+    return reader;
+}
+
+std::vector<maze::Direction> readWalls(BlobReader &reader, uint32_t size) {
+    if (static_cast<uint64_t>(size) * size > reader.getRemaining())
+        throw error { "save_state.cpp", "shrekrooms::save::readMaze", "Maze is larger than the data" };
+
+    std::vector<maze::Direction> walls(size*size);
+    for (maze::Direction &wall : walls)
+        wall = static_cast<maze::Direction>(reader.read<uint8_t>() & static_cast<uint8_t>(maze::Direction::All));
+    return walls;
+}
+
+
+} // namespace
+
+
+void shrekrooms::save::writeState(const Simulation &sim, std::vector<uint8_t> &blob) {
+    const maze::Maze &maze = sim.getWorld().getMaze();
+    const ecs::Registry &registry = sim.getRegistry();
+    const int size = static_cast<int>(maze.getSize());
+
+    blob.clear();
+    // Usual size up front, so the common case never reallocates
+    blob.reserve(32 + size*size + 4*registry.getFreeIds().size() + 96*registry.size());
+    BlobWriter writer { blob };
+
+    writer.write(magic);
+    writer.write(version);
+    writer.write(sim.getTick());
+
+    writer.write(static_cast<uint32_t>(size));
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++)
+            writer.write(static_cast<uint8_t>(maze.getNode({ x, y }).walls));
+    }
+
+    const std::vector<ecs::EntityID> &freeIds = registry.getFreeIds();
+    writer.write(static_cast<uint32_t>(freeIds.size()));
+    writer.writeBytes(freeIds.data(), freeIds.size() * sizeof(ecs::EntityID));
+
+    // Storage order, so iteration order survives the round trip
+    writer.write(static_cast<uint32_t>(registry.size()));
+    registry.eachArchetype<>([&](size_t count, const ecs::EntityID *entities) {
+        const ecs::ComponentMask mask = registry.getMask(entities[0]);
+        for (size_t i = 0; i < count; i++) {
+            writer.write(entities[i]);
+            writer.write(mask);
+            writeComponents(writer, registry, entities[i], mask, static_cast<ecs::ComponentTypes *>(nullptr));
+        }
+    });
+}
+
+std::unique_ptr<maze::Maze> shrekrooms::save::readMaze(const std::vector<uint8_t> &blob) {
+    BlobReader reader = readHeader(blob, "shrekrooms::save::readMaze");
+    reader.read<uint64_t>();
+
+    const uint32_t size = reader.read<uint32_t>();
+    return std::make_unique<maze::Maze>(size, readWalls(reader, size));
+}
+
+void shrekrooms::save::readState(const std::vector<uint8_t> &blob, Simulation &sim) {
+    BlobReader reader = readHeader(blob, "shrekrooms::save::readState");
+    const uint64_t tick = reader.read<uint64_t>();
+
+    const maze::Maze &maze = sim.getWorld().getMaze();
+    const uint32_t size = reader.read<uint32_t>();
+    if (size != maze.getSize())
+        throw error { "save_state.cpp", "shrekrooms::save::readState", "Saved in a different maze" };
+    const std::vector<maze::Direction> walls = readWalls(reader, size);
+    for (int x = 0; x < static_cast<int>(size); x++) {
+        for (int y = 0; y < static_cast<int>(size); y++) {
+            if (walls[x*size + y] != maze.getNode({ x, y }).walls)
+                throw error { "save_state.cpp", "shrekrooms::save::readState", "Saved in a different maze" };
+        }
+    }
+
+    const uint32_t freeCount = reader.read<uint32_t>();
+    if (freeCount > reader.getRemaining() / sizeof(ecs::EntityID))
+        throw error { "save_state.cpp", "shrekrooms::save::readState", "Free list is longer than the data" };
+    std::vector<ecs::EntityID> freeIds(freeCount);
+    reader.readBytes(freeIds.data(), freeCount * sizeof(ecs::EntityID));
+
+    // Parsed into a scratch registry first, a broken blob leaves sim untouched
+    ecs::Registry registry;
+    const uint32_t entityCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < entityCount; i++) {
+        const ecs::EntityID id = reader.read<ecs::EntityID>();
+        const ecs::ComponentMask mask = reader.read<ecs::ComponentMask>();
+        if (mask & ~allComponents(static_cast<ecs::ComponentTypes *>(nullptr)))
+            throw error { "save_state.cpp", "shrekrooms::save::readState", "Unknown component" };
+
+        registry.createAt(id, mask);
+        readComponents(reader, registry, id, mask, static_cast<ecs::ComponentTypes *>(nullptr));
+    }
+    registry.setFreeIds(std::move(freeIds));
+
+    sim.getRegistry() = std::move(registry);
+    sim.restoreTick(tick);
+}
+
+void shrekrooms::save::writeFile(const std::string &path, const std::vector<uint8_t> &blob) {
+    std::ofstream file { path, std::ios::binary };
+    if (!file.write(reinterpret_cast<const char *>(blob.data()), blob.size()))
+        throw error { "save_state.cpp", "shrekrooms::save::writeFile", "Failed to write '" + path + "'" };
+}
+
+std::vector<uint8_t> shrekrooms::save::readFile(const std::string &path) {
+    std::ifstream file { path, std::ios::binary | std::ios::ate };
+    if (!file)
+        throw error { "save_state.cpp", "shrekrooms::save::readFile", "Failed to open '" + path + "'" };
+
+    std::vector<uint8_t> blob(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(blob.data()), blob.size()))
+        throw error { "save_state.cpp", "shrekrooms::save::readFile", "Failed to read '" + path + "'" };
+    return blob;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "defines.hpp"
+#include "simulation.hpp"
+#include "blob.hpp"
+
+
+/*
+ * Whole game state as one flat binary blob: the maze walls, the tick counter
+ * and every entity with all of its components. Size grows linearly with the
+ * maze area and the entity count
+*/
+namespace shrekrooms::save {
+
+
+void writeState(const Simulation &sim, std::vector<uint8_t> &blob);
+
+// The maze a blob was saved in, to build the World it is restored into
+std::unique_ptr<maze::Maze> readMaze(const std::vector<uint8_t> &blob);
+// Replaces every entity of sim, its world has to be built on the saved maze
+void readState(const std::vector<uint8_t> &blob, Simulation &sim);
+
+void writeFile(const std::string &path, const std::vector<uint8_t> &blob);
+std::vector<uint8_t> readFile(const std::string &path);
+
+
+} // namespace shrekrooms::save
@@ -0,0 +1,259 @@
+#include "server.hpp"
+
+using namespace shrekrooms::net;
+
+
+/*
+ * class shrekrooms::net::Server
+*/
+
+Server::Server(Simulation &sim, rng::Random::Seed seed, uint16_t port) :
+        m_sim(sim), m_seed(seed), m_random(seed), m_socket(port), m_nextInputIndex(0), m_stats() {
+    // Players already in the simulation keep their inputs, clients get the following ones
+    m_sim.getRegistry().each<ecs::Controller>([this](ecs::EntityID, const ecs::Controller &controller) {
+        m_nextInputIndex = std::max(m_nextInputIndex, controller.inputIndex + 1);
+    });
+}
+
+uint16_t Server::getPort() const {
+    return m_socket.getPort();
+}
+
+size_t Server::getClientCount() const {
+    return m_connections.size();
+}
+
+void Server::tick() {
+    const auto startTime = Clock::now();
+
+    m_receive();
+    m_dropTimedOut();
+
+    m_inputs.assign(m_nextInputIndex, PlayerInput {});
+    for (Connection &connection : m_connections) {
+        if (!connection.queuedInputs.empty()) {
+            connection.lastAppliedSeq = connection.queuedInputs.front().first;
+            connection.lastInput = connection.queuedInputs.front().second;
+            connection.queuedInputs.pop_front();
+        }
+        m_inputs[connection.inputIndex] = connection.lastInput;
+    }
+    m_sim.tick(m_inputs);
+
+    m_sendSnapshots();
+
+    const float seconds = std::chrono::duration_cast<DurationSecondsFloat>(Clock::now() - startTime).count();
+    m_stats.ticks++;
+    m_stats.tickSeconds += seconds;
+    m_stats.maxTickSeconds = std::max(m_stats.maxTickSeconds, seconds);
+    m_stats.clientTicks += m_connections.size();
+}
+
+const Server::Stats &Server::getStats() const {
+    return m_stats;
+}
+
+void Server::resetStats() {
+    m_stats = {};
+}
+
+void Server::m_receive() {
+    Address from;
+    while (m_socket.receive(from, m_received)) {
+        m_stats.bytesReceived += m_received.size();
+
+        BlobReader reader { m_received.data(), m_received.size() };
+        PacketType type;
+        if (!readHeader(reader, type))
+            continue;
+
+        const auto it = m_connectionIndices.find(from.getKey());
+        if (it == m_connectionIndices.end()) {
+            if (type == PacketType::Connect)
+                m_connect(from);
+            continue;
+        }
+
+        Connection &connection = m_connections[it->second];
+        connection.lastHeard = Clock::now();
+
+        try {
+            switch (type) {
+                case PacketType::Connect:
+                    // The Welcome got lost
+                    m_sendWelcome(connection);
+                    break;
+                case PacketType::Input: {
+                    const uint64_t ackedTick = reader.read<uint64_t>();
+                    if (ackedTick != noTick && (connection.ackedTick == noTick || ackedTick > connection.ackedTick))
+                        connection.ackedTick = ackedTick;
+
+                    const uint32_t firstSeq = reader.read<uint32_t>();
+                    const uint8_t count = reader.read<uint8_t>();
+                    for (uint32_t seq = firstSeq; seq < firstSeq + count; seq++) {
+                        const PlayerInput input = readInput(reader);
+                        if (seq > connection.lastQueuedSeq) {
+                            connection.queuedInputs.emplace_back(seq, input);
+                            connection.lastQueuedSeq = seq;
+                        }
+                    }
+                    while (connection.queuedInputs.size() > defines::net::maxQueuedInputs)
+                        connection.queuedInputs.pop_front();
+                    break;
+                }
+                case PacketType::Disconnect:
+                    m_disconnect(it->second);
+                    break;
+                default:
+                    break;
+            }
+        } catch (const error &) {
+            // A malformed packet is dropped like a lost one
+        }
+    }
+}
+
+void Server::m_connect(const Address &address) {
+    size_t inputIndex = m_nextInputIndex;
+    if (m_freeInputIndices.empty()) {
+        m_nextInputIndex++;
+    } else {
+        inputIndex = m_freeInputIndices.back();
+        m_freeInputIndices.pop_back();
+    }
+
+    rng::RandInt randCell = m_random.getRandInt(0, static_cast<int>(m_sim.getWorld().getMaze().getSize()) - 1);
+    const int x = randCell.get();
+    const WorldPos pos { { x, randCell.get() }, { 0.0f, 0.0f, 0.0f } };
+
+    Connection connection {
+        address,
+        spawnPlayer(m_sim.getRegistry(), pos, 0.0f, inputIndex),
+        inputIndex,
+        { }, 0, 0, { },
+        noTick,
+        { },
+        Clock::now()
+    };
+    m_connectionIndices[address.getKey()] = m_connections.size();
+    m_connections.push_back(std::move(connection));
+    m_sendWelcome(m_connections.back());
+}
+
+void Server::m_disconnect(size_t index) {
+    Connection &connection = m_connections[index];
+    m_sim.getRegistry().destroy(connection.entity);
+    m_freeInputIndices.push_back(connection.inputIndex);
+    m_connectionIndices.erase(connection.address.getKey());
+
+    // Moves the last connection into index
+    if (index + 1 != m_connections.size()) {
+        connection = std::move(m_connections.back());
+        m_connectionIndices[connection.address.getKey()] = index;
+    }
+    m_connections.pop_back();
+}
+
+void Server::m_dropTimedOut() {
+    const auto now = Clock::now();
+    for (size_t i = m_connections.size(); i-- > 0;) {
+        if (std::chrono::duration_cast<DurationSecondsFloat>(now - m_connections[i].lastHeard).count() > defines::net::clientTimeout)
+            m_disconnect(i);
+    }
+}
+
+bool Server::m_send(const Address &address) {
+    try {
+        m_socket.send(address, m_packet);
+    } catch (const error &) {
+        m_stats.failedSends++;
+        return false;
+    }
+    m_stats.bytesSent += m_packet.size();
+    return true;
+}
+
+void Server::m_sendWelcome(const Connection &connection) {
+    m_packet.clear();
+    BlobWriter writer { m_packet };
+    writeHeader(writer, PacketType::Welcome);
+    writer.write<rng::Random::Seed>(m_seed);
+    writer.write<ecs::EntityID>(connection.entity);
+    writer.write<uint64_t>(m_sim.getTick());
+
+    m_send(connection.address);
+}
+
+void Server::m_sendSnapshots() {
+    const SimSnapshot curr = m_sim.getSnapshot();
+    const size_t payload = defines::net::maxSnapshotPayload;
+
+    for (auto &[key, entities] : m_chunkEntities)
+        entities.clear();
+    for (uint32_t i = 0; i < curr.entities.size(); i++)
+        m_chunkEntities[getChunkKey(curr.entities[i].pos.chunk)].push_back(i);
+
+    for (Connection &connection : m_connections) {
+        const EntitySnapshot *own = curr.find(connection.entity);
+        SimSnapshot relevant { curr.tick, { } };
+        m_gatherRelevant(curr, own ? own->pos.chunk : glm::ivec2 { 0, 0 }, relevant);
+
+        // The sent snapshots are consecutive ticks
+        std::deque<SimSnapshot> &sent = connection.sent;
+        const SimSnapshot *base = nullptr;
+        if (connection.ackedTick != noTick && !sent.empty() && connection.ackedTick >= sent.front().tick && connection.ackedTick <= sent.back().tick)
+            base = &sent[connection.ackedTick - sent.front().tick];
+        if (!base)
+            m_stats.fullSnapshots++;
+        const uint64_t baseTick = base ? base->tick : noTick;
+
+        m_delta.clear();
+        BlobWriter deltaWriter { m_delta };
+        writeSnapshotDelta(deltaWriter, base, relevant);
+
+        // Too many fragments to number is counted like a refused datagram
+        size_t count = (m_delta.size() + payload - 1) / payload;
+        if (count > UINT16_MAX) {
+            m_stats.failedSends++;
+            count = 0;
+        }
+        for (size_t i = 0; i < count; i++) {
+            m_packet.clear();
+            BlobWriter writer { m_packet };
+            writeHeader(writer, PacketType::Snapshot);
+            writer.write<uint64_t>(curr.tick);
+            writer.write<uint64_t>(baseTick);
+            writer.write<uint32_t>(connection.lastAppliedSeq);
+            writer.write<uint16_t>(static_cast<uint16_t>(i));
+            writer.write<uint16_t>(static_cast<uint16_t>(count));
+            writer.writeBytes(m_delta.data() + i*payload, std::min(payload, m_delta.size() - i*payload));
+
+            // The rest would be useless without this one
+            if (!m_send(connection.address))
+                break;
+        }
+
+        sent.push_back(std::move(relevant));
+        while (sent.size() > defines::net::snapshotHistory)
+            sent.pop_front();
+    }
+}
+
+void Server::m_gatherRelevant(const SimSnapshot &curr, const glm::ivec2 &center, SimSnapshot &res) {
+    const int radius = defines::net::relevanceRadius;
+
+    m_relevant.clear();
+    for (int x = center.x - radius; x <= center.x + radius; x++) {
+        for (int y = center.y - radius; y <= center.y + radius; y++) {
+            const auto it = m_chunkEntities.find(getChunkKey({ x, y }));
+            if (it != m_chunkEntities.end())
+                m_relevant.insert(m_relevant.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    // The snapshot is sorted by id, so its indices keep the order
+    std::sort(m_relevant.begin(), m_relevant.end());
+    res.entities.reserve(m_relevant.size());
+    for (uint32_t i : m_relevant)
+        res.entities.push_back(curr.entities[i]);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "defines.hpp"
+#include "net.hpp"
+#include "net_protocol.hpp"
+#include "simulation.hpp"
+
+
+namespace shrekrooms::net {
+
+
+/*
+ * Authoritative host of a Simulation. Every client gets a player entity driven by the
+ * inputs it sends, and each tick a snapshot delta against the last one it acknowledged.
+ * Snapshots only hold the entities near the client's player and are split into
+ * datagrams of at most defines::net::maxSnapshotPayload bytes
+*/
+class Server {
+public:
+    struct Stats {
+        size_t ticks;
+        float tickSeconds;      // Summed over ticks
+        float maxTickSeconds;
+        size_t clientTicks;     // Connected clients summed over ticks
+        size_t bytesSent;
+        size_t bytesReceived;
+        size_t fullSnapshots;   // Sent without a base, to new clients or after heavy loss
+        size_t failedSends;     // Datagrams the socket refused, the client is sent the next tick's snapshot
+
+    };
+
+    // seed is the one the simulation's maze was generated from, clients check it
+    Server(Simulation &sim, rng::Random::Seed seed, uint16_t port);
+
+    uint16_t getPort() const;
+    size_t getClientCount() const;
+
+    // Handles every waiting packet, ticks the simulation once and sends each client its snapshot
+    void tick();
+
+    const Stats &getStats() const;
+    void resetStats();
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        Address address;
+        ecs::EntityID entity;
+        size_t inputIndex;
+        std::deque<std::pair<uint32_t, PlayerInput>> queuedInputs;
+        uint32_t lastQueuedSeq;
+        uint32_t lastAppliedSeq;
+        PlayerInput lastInput;      // Repeated while no new input arrives
+        uint64_t ackedTick;
+        std::deque<SimSnapshot> sent;   // Delta bases, one per tick
+        Clock::time_point lastHeard;
+
+    };
+
+    Simulation &m_sim;
+    rng::Random::Seed m_seed;
+    rng::Random m_random;
+    UdpSocket m_socket;
+
+    std::vector<Connection> m_connections;
+    std::unordered_map<uint64_t, size_t> m_connectionIndices;   // By Address::getKey()
+    size_t m_nextInputIndex;
+    std::vector<size_t> m_freeInputIndices;
+
+    std::vector<PlayerInput> m_inputs;
+    // Indices into the current snapshot, by chunk key
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_chunkEntities;
+    std::vector<uint32_t> m_relevant;
+    std::vector<uint8_t> m_received;
+    std::vector<uint8_t> m_delta;
+    std::vector<uint8_t> m_packet;
+    Stats m_stats;
+
+    void m_receive();
+    void m_connect(const Address &address);
+    void m_disconnect(size_t index);
+    void m_dropTimedOut();
+    // False if the socket refused it, which only costs this datagram
+    bool m_send(const Address &address);
+    void m_sendWelcome(const Connection &connection);
+    void m_sendSnapshots();
+    // Entities of curr within defines::net::relevanceRadius chunks of center
+    void m_gatherRelevant(const SimSnapshot &curr, const glm::ivec2 &center, SimSnapshot &res);
+
+};
+
+
+} // namespace shrekrooms::net
@@ -3,70 +3,81 @@
 using namespace shrekrooms;
 
 
-Shrek::Shrek(const gl::GLContext &glc, const maze::Maze &maze, const glm::ivec2 &mazePos) : 
-        m_glc(glc), m_meshman(glc.getMeshManager()), m_uniman(glc.getUniformManager()), m_maze(maze), m_mazePos(mazePos) {
-    glm::vec2 tmp = defines::world::chunkSize * static_cast<glm::vec2>(m_mazePos);
-    m_pos = { tmp.x, 0.0f, tmp.y };
-    m_getShortestPath({ 0, 0 });
-}
-
-void Shrek::update(const World &world, const Player &player, float dt) {
-    static glm::vec3 nextPos = m_pos;
-
-    if (m_mazePos == worldToChunkCoords(player.getPos()))
-        nextPos = player.getPos();
-    else if (glm::distance(m_pos, nextPos) < 0.1f) {
-        if (m_targetPath.empty())
-            m_getShortestPath(worldToChunkCoords(player.getPos()));
+static void updatePursuer(const ecs::Registry &registry, const World &world, ecs::Transform &transform, ecs::Velocity &velocity, ecs::Pursuer &pursuer, float dt) {
+    velocity.vel = { 0.0f, 0.0f };
+    if (!registry.has<ecs::Transform>(pursuer.target))
+        return;
+
+    const WorldPos &pos = transform.pos;
+    const WorldPos &targetPos = registry.get<ecs::Transform>(pursuer.target).pos;
+    const glm::vec3 from = pos.toWorld();
+    const glm::vec3 to = targetPos.toWorld();
+    if (pursuer.mazePos == targetPos.chunk || world.hasLineOfSight({ from.x, from.z }, { to.x, to.z })) {
+        // Head straight for the target, the path is rebuilt from here once it is out of sight
+        pursuer.nextPos = targetPos;
+        pursuer.mazePos = pos.chunk;
+        pursuer.path.clear();
+    } else if (glm::length(pursuer.nextPos.relativeTo(pos)) < 0.1f) {
+        if (pursuer.path.empty()) {
+            pursuer.mazePos = pos.chunk;
+            findMazePath(world.getMaze(), pursuer.mazePos, targetPos.chunk, pursuer.path);
+        }
+        if (pursuer.path.empty())
+            return;
 
-        m_mazePos = m_targetPath.back();
-        glm::vec2 tmp = defines::world::chunkSize * static_cast<glm::vec2>(m_targetPath.back());
-        m_targetPath.pop_back();
-        nextPos = { tmp.x, 0.0f, tmp.y };
+        pursuer.mazePos = pursuer.path.back();
+        pursuer.nextPos = { pursuer.path.back(), { 0.0f, 0.0f, 0.0f } };
+        pursuer.path.pop_back();
     }
 
-    glm::vec3 dir = glm::normalize(nextPos - m_pos);
-    m_pos += defines::shrek::walkSpeed * dt * dir;
+    const glm::vec3 diff = pursuer.nextPos.relativeTo(pos);
+    const float dist = glm::length(diff);
+    if (dist > 0.0f) {
+        const float step = std::min(defines::shrek::walkSpeed * dt, dist);
+        velocity.vel = step / (dist * dt) * glm::vec2 { diff.x, diff.z };
+    }
 }
 
-void Shrek::draw(const Player &player) const {
-    glm::vec3 playerPos = player.getPos();
-
-    // Position based
-    float angle = glm::acos(glm::dot(glm::normalize(m_pos - playerPos), { 1.0f, 0.0f, 0.0f }));
-    if (m_pos.z - playerPos.z < 0) angle = -angle;
-    glm::mat4 rotMat = glm::rotate(defines::mat4identity, -angle, defines::globalUp);
-    m_uniman.setRotateMatrix(rotMat);
 
-    // View direction based
-    // glm::mat4 rotMat = glm::rotate(defines::mat4identity, -player.getCameraRot(), defines::globalUp);
+ecs::EntityID shrekrooms::spawnShrek(ecs::Registry &registry, const maze::Maze &maze, const glm::ivec2 &mazePos, ecs::EntityID target) {
+    const WorldPos pos { mazePos, { 0.0f, 0.0f, 0.0f } };
 
-    // m_uniman.setRotateMatrix(rotMat);
+    ecs::Pursuer pursuer { target, pos, mazePos, { } };
+    if (registry.has<ecs::Transform>(target))
+        findMazePath(maze, mazePos, registry.get<ecs::Transform>(target).pos.chunk, pursuer.path);
 
-    glm::mat4 transMat = glm::translate(defines::mat4identity, m_pos);
-
-    m_uniman.setTranslateMatrix(transMat);
-    m_meshman.renderMesh(s_mesh);
-    m_uniman.setRotateMatrix(defines::mat4identity);
+    return registry.create(
+        ecs::Transform { pos, 0.0f },
+        ecs::Velocity { { 0.0f, 0.0f } },
+        ecs::Collider { defines::shrek::radius, false },
+        std::move(pursuer),
+        ecs::Sprite { ecs::SpriteID::Shrek }
+    );
 }
 
-bool Shrek::isCollidingPlayer(const Player &player) const {
-    return glm::distance(player.getPos(), m_pos) < (defines::shrek::radius + defines::player::radius);
+void shrekrooms::updatePursuers(ecs::Registry &registry, const World &world, jobs::JobSystem &jobs, float dt) {
+    const ecs::Registry &constRegistry = registry;
+    registry.eachArchetype<ecs::Transform, ecs::Velocity, ecs::Pursuer>([&](size_t count, const ecs::EntityID *, ecs::Transform *transforms, ecs::Velocity *velocities, ecs::Pursuer *pursuers) {
+        jobs.parallelFor(0, count, 8, [&](size_t i) {
+            updatePursuer(constRegistry, world, transforms[i], velocities[i], pursuers[i], dt);
+        });
+    });
 }
 
-void shrekrooms::Shrek::m_getShortestPath(const glm::ivec2 &target) {
+void shrekrooms::findMazePath(const maze::Maze &maze, const glm::ivec2 &from, const glm::ivec2 &to, std::vector<glm::ivec2> &path) {
     using namespace maze;
     using NodeT = glm::ivec2;
     static const NodeT undefinedNode { -1, -1 };
 
-    Grid<size_t> dist { defines::world::chunksCountWidth, defines::world::chunksCountWidth, SIZE_MAX };
-    dist[m_mazePos] = 0;
+    const size_t size = maze.getSize();
+    Grid<size_t> dist { size, size, SIZE_MAX };
+    dist[from] = 0;
 
-    Grid<NodeT> prev { defines::world::chunksCountWidth, defines::world::chunksCountWidth, undefinedNode };
+    Grid<NodeT> prev { size, size, undefinedNode };
 
     std::deque<NodeT> que;
-    for (int x = 0; x < defines::world::chunksCountWidth; x++) {
-        for (int y = 0; y < defines::world::chunksCountWidth; y++)
+    for (int x = 0; x < static_cast<int>(size); x++) {
+        for (int y = 0; y < static_cast<int>(size); y++)
             que.emplace_back(x, y);
     }
 
@@ -79,12 +90,15 @@ void shrekrooms::Shrek::m_getShortestPath(const glm::ivec2 &target) {
                 u = n;
             }
         }
-        if (u == target)
+        // The rest can't be reached
+        if (minDist == SIZE_MAX)
+            break;
+        if (u == to)
             break;
         que.erase(std::find(que.begin(), que.end(), u));
 
         for (Direction dir : allDirections) {
-            if (m_maze.getNode(u).hasWall(dir))
+            if (maze.getNode(u).hasWall(dir))
                 continue;
 
             v = u + getDirectionVector(dir);
@@ -96,14 +110,15 @@ void shrekrooms::Shrek::m_getShortestPath(const glm::ivec2 &target) {
         }
     }
 
-    m_targetPath.clear();
-    u = target;
-    if (prev[u] != undefinedNode || u == m_mazePos) {
+    path.clear();
+    u = to;
+    if (prev[u] != undefinedNode || u == from) {
         while (u != undefinedNode) {
-            m_targetPath.push_back(u);
+            path.push_back(u);
             u = prev[u];
         }
     }
-    if (m_targetPath.size() != 1)
-        m_targetPath.pop_back();
+    // Drop the cell we start in, unless it is the destination
+    if (path.size() > 1)
+        path.pop_back();
 }
@@ -1,35 +1,21 @@
 #pragma once
 
 #include "defines.hpp"
-#include "player.hpp"
-#include "maze.hpp"
+#include "ecs.hpp"
+#include "jobs.hpp"
+#include "world.hpp"
 
 
 namespace shrekrooms {
 
 
-class Shrek {
-public:
-    Shrek(const gl::GLContext &glc, const maze::Maze &maze, const glm::ivec2 &mazePos);
+ecs::EntityID spawnShrek(ecs::Registry &registry, const maze::Maze &maze, const glm::ivec2 &mazePos, ecs::EntityID target);
 
-    void update(const World &world, const Player &player, float dt);
-    void draw(const Player &player) const;
-    bool isCollidingPlayer(const Player &player) const;
+// Picks every Pursuer's velocity. Pursuers only read each other's transforms, so they run in parallel
+void updatePursuers(ecs::Registry &registry, const World &world, jobs::JobSystem &jobs, float dt);
 
-protected:
-    static constexpr MeshManager::Mesh s_mesh = MeshManager::Mesh::Shrek;
-    const gl::GLContext &m_glc;
-    const MeshManager &m_meshman;
-    const UniformManager &m_uniman;
-    const maze::Maze &m_maze;
-    gl::Texture m_tex;
-    glm::vec3 m_pos;
-    glm::ivec2 m_mazePos;
-    std::deque<glm::ivec2> m_targetPath;
-
-    void m_getShortestPath(const glm::ivec2 &target);
-
-};
+// Cells leading from 'from' to 'to', the next one at the back. Empty if 'to' can't be reached
+void findMazePath(const maze::Maze &maze, const glm::ivec2 &from, const glm::ivec2 &to, std::vector<glm::ivec2> &path);
 
 
 } // namespace shrekrooms
@@ -0,0 +1,334 @@
+#include "simulation.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * struct shrekrooms::SimSnapshot
+*/
+
+const EntitySnapshot *SimSnapshot::find(ecs::EntityID id) const {
+    auto it = std::lower_bound(entities.begin(), entities.end(), id, [](const EntitySnapshot &entity, ecs::EntityID id) {
+        return entity.id < id;
+    });
+    return (it != entities.end() && it->id == id) ? &*it : nullptr;
+}
+
+SimSnapshot SimSnapshot::interpolate(const SimSnapshot &prev, const SimSnapshot &curr, float alpha) {
+    SimSnapshot res = curr;
+
+    // Both are sorted by id, so matching entities are found in one pass
+    auto it = prev.entities.begin();
+    for (EntitySnapshot &entity : res.entities) {
+        while (it != prev.entities.end() && it->id < entity.id)
+            it++;
+        if (it == prev.entities.end() || it->id != entity.id)
+            continue;
+
+        // Rotations are never wrapped, so a plain lerp takes the short way
+        entity.pos = WorldPos::s_mix(it->pos, entity.pos, alpha);
+        entity.rot = glm::mix(it->rot, entity.rot, alpha);
+    }
+    return res;
+}
+
+
+/*
+ * class shrekrooms::Simulation
+*/
+
+Simulation::Simulation(const World &world, jobs::JobSystem &jobs) :
+    m_world(world), m_jobs(jobs), m_tick(0), m_contactHash(defines::simulation::contactCellSize) { }
+
+const World &Simulation::getWorld() const {
+    return m_world;
+}
+
+ecs::Registry &Simulation::getRegistry() {
+    return m_registry;
+}
+
+const ecs::Registry &Simulation::getRegistry() const {
+    return m_registry;
+}
+
+void Simulation::tick(const std::vector<PlayerInput> &inputs) {
+    const float dt = s_getTickDuration();
+
+    // Velocities are picked from the state at the start of the tick, then everything moves at once
+    updatePlayers(m_registry, inputs, dt);
+    updatePursuers(m_registry, m_world, m_jobs, dt);
+    m_moveEntities(dt);
+    m_findContacts();
+    m_separateContacts();
+
+    m_tick++;
+}
+
+void Simulation::tick(const PlayerInput &input) {
+    tick(std::vector<PlayerInput> { input });
+}
+
+uint64_t Simulation::getTick() const {
+    return m_tick;
+}
+
+void Simulation::restoreTick(uint64_t tick) {
+    m_tick = tick;
+    m_findContacts();
+}
+
+const std::vector<Contact> &Simulation::getContacts() const {
+    return m_contacts;
+}
+
+SimSnapshot Simulation::getSnapshot() const {
+    SimSnapshot snapshot { m_tick, { } };
+    snapshot.entities.reserve(m_registry.size());
+    m_registry.each<ecs::Transform>([&snapshot](ecs::EntityID id, const ecs::Transform &transform) {
+        snapshot.entities.push_back({ id, transform.pos, transform.rot, false, ecs::SpriteID::Shrek });
+    });
+    std::sort(snapshot.entities.begin(), snapshot.entities.end(), [](const EntitySnapshot &a, const EntitySnapshot &b) {
+        return a.id < b.id;
+    });
+
+    m_registry.each<ecs::Transform, ecs::Sprite>([&snapshot](ecs::EntityID id, const ecs::Transform &, const ecs::Sprite &sprite) {
+        EntitySnapshot &entity = const_cast<EntitySnapshot &>(*snapshot.find(id));
+        entity.hasSprite = true;
+        entity.sprite = sprite.id;
+    });
+    return snapshot;
+}
+
+uint64_t Simulation::getStateHash() const {
+    const SimSnapshot snapshot = getSnapshot();
+
+    uint64_t hash = 0xcbf29ce484222325;
+    const auto addBytes = [&hash](const void *data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<const uint8_t *>(data)[i];
+            hash *= 0x100000001b3;
+        }
+    };
+    addBytes(&snapshot.tick, sizeof(snapshot.tick));
+    for (const EntitySnapshot &entity : snapshot.entities) {
+        addBytes(&entity.id, sizeof(entity.id));
+        addBytes(&entity.pos.chunk, sizeof(entity.pos.chunk));
+        addBytes(&entity.pos.local, sizeof(entity.pos.local));
+        addBytes(&entity.rot, sizeof(entity.rot));
+    }
+    return hash;
+}
+
+float Simulation::s_getTickDuration() {
+    return 1.0f / defines::simulation::tickRate;
+}
+
+
+void Simulation::m_moveEntities(float dt) {
+    m_registry.eachArchetype<ecs::Transform, ecs::Velocity>([dt](size_t count, const ecs::EntityID *, ecs::Transform *transforms, const ecs::Velocity *velocities) {
+        for (size_t i = 0; i < count; i++)
+            transforms[i].pos += dt * glm::vec3 { velocities[i].vel.x, 0.0f, velocities[i].vel.y };
+    }, ecs::componentBit<ecs::Collider>);
+
+    m_registry.eachArchetype<ecs::Transform, ecs::Velocity, ecs::Collider>([this, dt](size_t count, const ecs::EntityID *, ecs::Transform *transforms, const ecs::Velocity *velocities, const ecs::Collider *colliders) {
+        m_jobs.parallelFor(0, count, 64, [&](size_t i) {
+            WorldPos &pos = transforms[i].pos;
+            const glm::vec2 delta = dt * velocities[i].vel;
+            if (!colliders[i].solid) {
+                pos += glm::vec3 { delta.x, 0.0f, delta.y };
+                return;
+            }
+
+            // Swept, so a long tick cannot carry anything through a wall
+            pos = m_world.moveCircle(pos, delta, colliders[i].radius);
+        });
+    });
+}
+
+void Simulation::m_findContacts() {
+    m_contactIds.clear();
+    m_contactPos.clear();
+    m_contactRadius.clear();
+    m_registry.each<ecs::Transform, ecs::Collider>([this](ecs::EntityID id, const ecs::Transform &transform, const ecs::Collider &collider) {
+        m_contactIds.push_back(id);
+        // Only sorts colliders into cells, the exact overlap is measured between WorldPos
+        const glm::vec3 pos = transform.pos.toWorld();
+        m_contactPos.push_back({ pos.x, pos.z });
+        m_contactRadius.push_back(collider.radius);
+    });
+
+    m_contactHash.rebuild(m_contactPos.data(), m_contactRadius.data(), m_contactPos.size());
+    m_contactPairs.clear();
+    m_contactHash.getContactPairs(m_contactPairs);
+
+    m_contacts.clear();
+    for (const SpatialHash::ContactPair &pair : m_contactPairs)
+        m_contacts.push_back({ m_contactIds[pair.first], m_contactIds[pair.second] });
+}
+
+void Simulation::m_separateContacts() {
+    // Entities on the same spot part along an angle picked from their ids, so runs stay reproducible
+    static constexpr float goldenAngle = 2.39996323f;
+
+    for (const SpatialHash::ContactPair &pair : m_contactPairs) {
+        const ecs::EntityID first = m_contactIds[pair.first];
+        const ecs::EntityID second = m_contactIds[pair.second];
+        const bool isFirstMoving = m_registry.has<ecs::Velocity>(first);
+        const bool isSecondMoving = m_registry.has<ecs::Velocity>(second);
+        if (!isFirstMoving && !isSecondMoving)
+            continue;
+
+        // Earlier pairs may have moved either of them already
+        const glm::vec3 diff3 = m_registry.get<ecs::Transform>(second).pos.relativeTo(m_registry.get<ecs::Transform>(first).pos);
+        const glm::vec2 diff { diff3.x, diff3.z };
+        const float dist = glm::length(diff);
+        const float overlap = m_contactRadius[pair.first] + m_contactRadius[pair.second] - dist;
+        if (overlap <= 0.0f)
+            continue;
+
+        const float angle = goldenAngle * static_cast<float>(first ^ second);
+        const glm::vec2 normal = (dist > 0.0f) ? diff / dist : glm::vec2 { std::cos(angle), std::sin(angle) };
+        const float firstShare = !isFirstMoving ? 0.0f : (!isSecondMoving ? 1.0f : 0.5f);
+        if (isFirstMoving)
+            m_pushEntity(first, -firstShare * overlap * normal, m_contactRadius[pair.first]);
+        if (isSecondMoving)
+            m_pushEntity(second, (1.0f - firstShare) * overlap * normal, m_contactRadius[pair.second]);
+    }
+}
+
+void Simulation::m_pushEntity(ecs::EntityID id, const glm::vec2 &delta, float radius) {
+    WorldPos &pos = m_registry.get<ecs::Transform>(id).pos;
+    if (!m_registry.get<ecs::Collider>(id).solid) {
+        pos += glm::vec3 { delta.x, 0.0f, delta.y };
+        return;
+    }
+
+    // Solid ones are never pushed into a wall
+    pos = m_world.moveCircle(pos, delta, radius);
+}
+
+
+/*
+ * class shrekrooms::SimulationThread
+*/
+
+SimulationThread::SimulationThread(Simulation &sim, InputLog *record) :
+        m_sim(sim), m_record(record), m_running(true), m_paused(false), m_currSnapshot(0), m_publishTime(Clock::now()) {
+    m_snapshots[0] = m_snapshots[1] = m_sim.getSnapshot();
+    m_thread = std::thread { &SimulationThread::m_run, this };
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::stop() {
+    m_running = false;
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void SimulationThread::setPaused(bool paused) {
+    m_paused = paused;
+
+    // Keys held when pausing must not keep the player walking after resuming
+    std::lock_guard<std::mutex> lock { m_inputMutex };
+    m_pendingInput = PlayerInput {};
+}
+
+bool SimulationThread::isPaused() const {
+    return m_paused;
+}
+
+void SimulationThread::addInput(const PlayerInput &input) {
+    if (m_paused)
+        return;
+
+    std::lock_guard<std::mutex> lock { m_inputMutex };
+    const float mouseDeltaX = m_pendingInput.mouseDeltaX + input.mouseDeltaX;
+    m_pendingInput = input;
+    m_pendingInput.mouseDeltaX = mouseDeltaX;
+}
+
+float SimulationThread::getPendingMouseDeltaX() const {
+    std::lock_guard<std::mutex> lock { m_inputMutex };
+    return m_pendingInput.mouseDeltaX;
+}
+
+void SimulationThread::post(std::function<void(Simulation &)> func) {
+    std::lock_guard<std::mutex> lock { m_taskMutex };
+    m_tasks.push_back(std::move(func));
+}
+
+void SimulationThread::getSnapshots(SimSnapshot &prev, SimSnapshot &curr, float &alpha) const {
+    Clock::time_point publishTime;
+    {
+        std::lock_guard<std::mutex> lock { m_snapshotMutex };
+        curr = m_snapshots[m_currSnapshot];
+        prev = m_snapshots[m_currSnapshot ^ 1];
+        publishTime = m_publishTime;
+    }
+
+    // Rendering runs one tick behind, so curr is reached just as the next snapshot arrives
+    const float sinceTick = std::chrono::duration_cast<DurationSecondsFloat>(Clock::now() - publishTime).count();
+    alpha = glm::clamp(sinceTick / Simulation::s_getTickDuration(), 0.0f, 1.0f);
+}
+
+PlayerInput SimulationThread::m_takeInput() {
+    std::lock_guard<std::mutex> lock { m_inputMutex };
+    PlayerInput input = m_pendingInput;
+    m_pendingInput.mouseDeltaX = 0.0f;
+    return input;
+}
+
+bool SimulationThread::m_runTasks() {
+    std::vector<std::function<void(Simulation &)>> tasks;
+    {
+        std::lock_guard<std::mutex> lock { m_taskMutex };
+        tasks.swap(m_tasks);
+    }
+
+    for (std::function<void(Simulation &)> &task : tasks)
+        task(m_sim);
+    return !tasks.empty();
+}
+
+void SimulationThread::m_publish(const SimSnapshot &snapshot, bool reset) {
+    std::lock_guard<std::mutex> lock { m_snapshotMutex };
+    // Overwrite the older buffer, the newer one becomes prev
+    m_currSnapshot ^= 1;
+    m_snapshots[m_currSnapshot] = snapshot;
+    if (reset)
+        m_snapshots[m_currSnapshot ^ 1] = snapshot;
+    m_publishTime = Clock::now();
+}
+
+void SimulationThread::m_run() {
+    const auto tickDuration = std::chrono::duration_cast<Clock::duration>(DurationSecondsFloat { Simulation::s_getTickDuration() });
+    Clock::time_point nextTick = Clock::now();
+
+    while (m_running) {
+        const Clock::time_point now = Clock::now();
+        if (now < nextTick) {
+            std::this_thread::sleep_until(nextTick);
+            continue;
+        }
+
+        // After a long stall drop the missed time instead of spiralling to catch up
+        if (now - nextTick > defines::simulation::maxCatchUpTicks * tickDuration)
+            nextTick = now;
+        nextTick += tickDuration;
+
+        if (m_runTasks())
+            m_publish(m_sim.getSnapshot(), true);
+        if (m_paused)
+            continue;
+
+        const PlayerInput input = m_takeInput();
+        if (m_record)
+            m_record->push(input);
+        m_sim.tick(input);
+        m_publish(m_sim.getSnapshot());
+    }
+}
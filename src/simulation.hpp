@@ -0,0 +1,152 @@
+#pragma once
+
+#include "defines.hpp"
+#include "player.hpp"
+#include "shrek.hpp"
+#include "input_log.hpp"
+#include "spatial_hash.hpp"
+
+
+namespace shrekrooms {
+
+
+struct EntitySnapshot {
+    ecs::EntityID id;
+    WorldPos pos;
+    float rot;
+    bool hasSprite;
+    ecs::SpriteID sprite;
+
+};
+
+
+struct SimSnapshot {
+    uint64_t tick;
+    std::vector<EntitySnapshot> entities;   // Sorted by id
+
+    const EntitySnapshot *find(ecs::EntityID id) const;
+
+    // Entities that only exist in curr are taken as they are
+    static SimSnapshot interpolate(const SimSnapshot &prev, const SimSnapshot &curr, float alpha);
+
+};
+
+
+struct Contact {
+    ecs::EntityID first, second;
+
+};
+
+
+/*
+ * Game logic advanced in fixed steps of 1/tickRate seconds,
+ * so its behaviour does not depend on the frame rate
+*/
+class Simulation {
+public:
+    Simulation(const World &world, jobs::JobSystem &jobs);
+
+    const World &getWorld() const;
+    ecs::Registry &getRegistry();
+    const ecs::Registry &getRegistry() const;
+
+    // inputs[i] drives the Controller with inputIndex i
+    void tick(const std::vector<PlayerInput> &inputs);
+    void tick(const PlayerInput &input);
+
+    uint64_t getTick() const;
+    // After the registry was restored from saved state
+    void restoreTick(uint64_t tick);
+    // Colliders that overlapped after moving in the last tick, they are pushed apart before it ends
+    const std::vector<Contact> &getContacts() const;
+    SimSnapshot getSnapshot() const;
+    // FNV-1a over the exact bits of the state, equal only for bit identical runs
+    uint64_t getStateHash() const;
+
+    static float s_getTickDuration();
+
+protected:
+    const World &m_world;
+    jobs::JobSystem &m_jobs;
+    ecs::Registry m_registry;
+    uint64_t m_tick;
+
+    SpatialHash m_contactHash;
+    std::vector<ecs::EntityID> m_contactIds;
+    std::vector<glm::vec2> m_contactPos;
+    std::vector<float> m_contactRadius;
+    std::vector<SpatialHash::ContactPair> m_contactPairs;
+    std::vector<Contact> m_contacts;
+
+    void m_moveEntities(float dt);
+    void m_findContacts();
+    // Entities with a Velocity share the overlap, the others stay where they are
+    void m_separateContacts();
+    void m_pushEntity(ecs::EntityID id, const glm::vec2 &delta, float radius);
+
+};
+
+
+/*
+ * Runs a Simulation on its own thread. Input is handed over from the render thread,
+ * state comes back as the two most recent snapshots for the renderer to interpolate
+*/
+class SimulationThread {
+public:
+    // Every tick's input is appended to record if given, it must outlive the thread
+    SimulationThread(Simulation &sim, InputLog *record = nullptr);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator =(const SimulationThread &) = delete;
+
+    // Joins the thread, the simulation is safe to read afterwards
+    void stop();
+
+    // A paused simulation does not tick and drops the input it is given
+    void setPaused(bool paused);
+    bool isPaused() const;
+
+    // Key states replace the previous ones, mouse motion adds up until the next tick
+    void addInput(const PlayerInput &input);
+    // Mouse motion handed over but not consumed by a tick yet, for turning the view ahead of the simulation
+    float getPendingMouseDeltaX() const;
+
+    // Runs func on the simulation thread before the next tick, also while paused.
+    // Input recordings don't capture what it changes
+    void post(std::function<void(Simulation &)> func);
+
+    // alpha is how far the present lies between prev and curr, in [0; 1]
+    void getSnapshots(SimSnapshot &prev, SimSnapshot &curr, float &alpha) const;
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    Simulation &m_sim;
+    InputLog *m_record;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_paused;
+
+    mutable std::mutex m_inputMutex;
+    PlayerInput m_pendingInput;
+
+    std::mutex m_taskMutex;
+    std::vector<std::function<void(Simulation &)>> m_tasks;
+
+    mutable std::mutex m_snapshotMutex;
+    std::array<SimSnapshot, 2> m_snapshots;
+    size_t m_currSnapshot;
+    Clock::time_point m_publishTime;
+
+    std::thread m_thread;   // Started last, once everything it touches exists
+
+    PlayerInput m_takeInput();
+    bool m_runTasks();
+    // reset replaces both buffers, so nothing is interpolated across a jump
+    void m_publish(const SimSnapshot &snapshot, bool reset = false);
+    void m_run();
+
+};
+
+
+} // namespace shrekrooms
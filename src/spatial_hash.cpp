@@ -0,0 +1,100 @@
+#include "spatial_hash.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * class shrekrooms::SpatialHash
+*/
+
+SpatialHash::SpatialHash(float cellSize) :
+        m_cellSize(cellSize), m_maxRadius(0.0f), m_bucketMask(0) {
+    if (cellSize <= 0.0f)
+        throw error { "spatial_hash.cpp", "shrekrooms::SpatialHash::SpatialHash", "'cellSize' has to be positive" };
+}
+
+void SpatialHash::rebuild(const glm::vec2 *pos, const float *radius, size_t count) {
+    m_pos.assign(pos, pos + count);
+    m_radius.assign(radius, radius + count);
+    m_cells.resize(count);
+    m_maxRadius = 0.0f;
+
+    // At least twice as many buckets as entities keeps hash collisions rare
+    size_t bucketCount = 1;
+    while (bucketCount < 2 * count)
+        bucketCount <<= 1;
+    m_bucketMask = bucketCount - 1;
+
+    // Counting sort of the entities by bucket
+    m_bucketStart.assign(bucketCount + 1, 0);
+    for (size_t i = 0; i < count; i++) {
+        m_cells[i] = m_getCell(pos[i]);
+        m_bucketStart[(s_hashCell(m_cells[i]) & m_bucketMask) + 1]++;
+        m_maxRadius = std::max(m_maxRadius, radius[i]);
+    }
+    for (size_t b = 0; b < bucketCount; b++)
+        m_bucketStart[b + 1] += m_bucketStart[b];
+
+    std::vector<uint32_t> fill { m_bucketStart.begin(), m_bucketStart.end() - 1 };
+    m_entries.resize(count);
+    for (size_t i = 0; i < count; i++)
+        m_entries[fill[s_hashCell(m_cells[i]) & m_bucketMask]++] = static_cast<EntityID>(i);
+}
+
+size_t SpatialHash::size() const {
+    return m_entries.size();
+}
+
+void SpatialHash::queryRadius(const glm::vec2 &pos, float radius, std::vector<EntityID> &res) const {
+    m_forEachNear(pos, radius, [&](EntityID id) {
+        const glm::vec2 diff = m_pos[id] - pos;
+        const float reach = radius + m_radius[id];
+        if (glm::dot(diff, diff) < reach*reach)
+            res.push_back(id);
+    });
+}
+
+void SpatialHash::getContactPairs(std::vector<ContactPair> &res) const {
+    for (EntityID first = 0; first < m_pos.size(); first++) {
+        m_forEachNear(m_pos[first], m_radius[first], [&](EntityID second) {
+            if (second <= first)
+                return;
+            const glm::vec2 diff = m_pos[second] - m_pos[first];
+            const float reach = m_radius[first] + m_radius[second];
+            if (glm::dot(diff, diff) < reach*reach)
+                res.push_back({ first, second });
+        });
+    }
+}
+
+size_t SpatialHash::s_hashCell(const glm::ivec2 &cell) {
+    return (static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u);
+}
+
+glm::ivec2 SpatialHash::m_getCell(const glm::vec2 &pos) const {
+    return static_cast<glm::ivec2>(glm::floor(pos / m_cellSize));
+}
+
+template <typename _Func>
+void SpatialHash::m_forEachNear(const glm::vec2 &pos, float radius, _Func func) const {
+    if (m_entries.empty())
+        return;
+
+    // Entities are filed by their centre, so widen the search by the largest radius
+    const float reach = radius + m_maxRadius;
+    const glm::ivec2 cellMin = m_getCell(pos - reach);
+    const glm::ivec2 cellMax = m_getCell(pos + reach);
+
+    for (int x = cellMin.x; x <= cellMax.x; x++) {
+        for (int y = cellMin.y; y <= cellMax.y; y++) {
+            const glm::ivec2 cell { x, y };
+            const size_t bucket = s_hashCell(cell) & m_bucketMask;
+            for (uint32_t i = m_bucketStart[bucket]; i < m_bucketStart[bucket + 1]; i++) {
+                // Other cells can share the bucket, skipping them also avoids reporting an entity twice
+                const EntityID id = m_entries[i];
+                if (m_cells[id] == cell)
+                    func(id);
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "defines.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Uniform grid broadphase for circles, rebuilt from scratch every tick.
+ * Entities are identified by their index in the arrays passed to rebuild()
+*/
+class SpatialHash {
+public:
+    using EntityID = uint32_t;
+
+    struct ContactPair {
+        EntityID first, second;
+    };
+
+    SpatialHash(float cellSize);
+
+    void rebuild(const glm::vec2 *pos, const float *radius, size_t count);
+    size_t size() const;
+
+    // Appends every entity whose circle overlaps the given one
+    void queryRadius(const glm::vec2 &pos, float radius, std::vector<EntityID> &res) const;
+    // Appends every overlapping pair once, first < second
+    void getContactPairs(std::vector<ContactPair> &res) const;
+
+protected:
+    float m_cellSize;
+    float m_maxRadius;
+    size_t m_bucketMask;
+    std::vector<glm::vec2> m_pos;
+    std::vector<float> m_radius;
+    std::vector<glm::ivec2> m_cells;
+    // Entities of bucket b are m_entries[m_bucketStart[b]; m_bucketStart[b+1])
+    std::vector<uint32_t> m_bucketStart;
+    std::vector<EntityID> m_entries;
+
+    static size_t s_hashCell(const glm::ivec2 &cell);
+
+    glm::ivec2 m_getCell(const glm::vec2 &pos) const;
+    template <typename _Func>
+    void m_forEachNear(const glm::vec2 &pos, float radius, _Func func) const;
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "imports.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Bounded queue without locks for one producer and one consumer thread.
+ * push() fails instead of blocking once _Capacity items are waiting
+*/
+template <typename _T, size_t _Capacity>
+class SpscQueue {
+public:
+    static_assert(_Capacity > 0 && (_Capacity & (_Capacity - 1)) == 0, "shrekrooms::SpscQueue::_Capacity has to be a power of two");
+
+    SpscQueue() :
+        m_head(0), m_tail(0) { }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator =(const SpscQueue &) = delete;
+
+    // Producer only
+    bool push(const _T &val) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == _Capacity)
+            return false;
+        m_items[tail & (_Capacity - 1)] = val;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool pop(_T &val) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        val = m_items[head & (_Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+protected:
+    // On separate cache lines, so the two threads don't invalidate each other's index
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+    std::array<_T, _Capacity> m_items;
+
+};
+
+
+} // namespace shrekrooms
@@ -0,0 +1,43 @@
+#include "startup_log.hpp"
+
+using namespace shrekrooms;
+
+
+static float toMillis(StartupLog::Clock::duration duration) {
+    return 1e3f * std::chrono::duration_cast<DurationSecondsFloat>(duration).count();
+}
+
+
+/*
+ * class shrekrooms::StartupLog
+*/
+
+StartupLog::StartupLog() :
+    m_start(Clock::now()), m_mainThread(std::this_thread::get_id()) { }
+
+void StartupLog::add(const std::string &name, Clock::time_point begin) {
+    const Clock::time_point end = Clock::now();
+    const bool isMainThread = (std::this_thread::get_id() == m_mainThread);
+
+    std::lock_guard<std::mutex> lock { m_mutex };
+    m_stages.push_back({ name, begin, end, isMainThread });
+}
+
+void StartupLog::print(std::ostream &out, const std::string &total) const {
+    const Clock::time_point now = Clock::now();
+
+    std::vector<Stage> stages;
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        stages = m_stages;
+    }
+    std::sort(stages.begin(), stages.end(), [](const Stage &a, const Stage &b) {
+        return a.begin < b.begin;
+    });
+
+    for (const Stage &stage : stages) {
+        out << "  at " << toMillis(stage.begin - m_start) << " ms: " << stage.name << " took " << toMillis(stage.end - stage.begin)
+            << " ms (" << (stage.isMainThread ? "main" : "worker") << ")\n";
+    }
+    out << total << ": " << toMillis(now - m_start) << " ms" << std::endl;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "imports.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Start-up stages with their start and duration, relative to the log's creation.
+ * Stages may be added from any thread
+*/
+class StartupLog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StartupLog();
+
+    // A stage that ran from begin until now
+    void add(const std::string &name, Clock::time_point begin);
+
+    // Every stage in order of their start, then the total up to now
+    void print(std::ostream &out, const std::string &total) const;
+
+protected:
+    struct Stage {
+        std::string name;
+        Clock::time_point begin, end;
+        bool isMainThread;
+
+    };
+
+    Clock::time_point m_start;
+    std::thread::id m_mainThread;
+
+    mutable std::mutex m_mutex;
+    std::vector<Stage> m_stages;
+
+};
+
+
+} // namespace shrekrooms
@@ -3,165 +3,105 @@
 using namespace shrekrooms;
 
 
-glm::ivec2 shrekrooms::worldToChunkCoords(const glm::vec2& pos) {
-    static const glm::vec2 cornerDiff { 0.5f * defines::world::chunkSize, 0.5f * defines::world::chunkSize };
-    glm::vec2 tmp = (pos + cornerDiff) / defines::world::chunkSize;
-    return static_cast<glm::ivec2>(tmp);
-}
-
-glm::ivec2 shrekrooms::worldToChunkCoords(const glm::vec3& pos) {
-    return worldToChunkCoords({ pos.x, pos.z });
-}
-
-
 /*
- * struct shrekrooms::Collision
+ * struct shrekrooms::ChunkTable
 */
 
-Collision::Collision() :
-    isColliding(false), cancelVector({ 0.0f, 0.0f }) { }
-
-Collision::Collision(bool isColliding, glm::vec2 cancelVector) :
-    isColliding(isColliding), cancelVector(cancelVector) { }
-
-void Collision::addOtherCollision(const Collision &coll) {
-    if (!coll.isColliding)
-        return;
-    isColliding = true;
-    cancelVector += coll.cancelVector;
+size_t ChunkTable::size() const {
+    return chunkPos.size();
 }
 
-
-/*
- * struct shrekrooms::Hitbox
-*/
-
-Hitbox::Hitbox() :
-    posMin(0.0f), posMax(0.0f) { }
-
-Hitbox::Hitbox(const glm::vec2 &posMin, const glm::vec2 &posMax) :
-    posMin(posMin), posMax(posMax) { }
-
-bool Hitbox::isInside(const glm::vec2 &pos) const {
-    return (
-        posMin.x <= pos.x && pos.x <= posMax.x &&  
-        posMin.y <= pos.y && pos.y <= posMax.y
-    );
+void ChunkTable::reserve(size_t count) {
+    chunkPos.reserve(count);
+    meshMasks.reserve(count);
 }
 
-Collision Hitbox::getCircleIntersection(const glm::vec2 &pos, float radius) const {
-    glm::vec2 closest = glm::clamp(pos, posMin, posMax);
-    float dist = glm::distance(pos, closest);
-    if (radius < dist)
-        return { };
-    glm::vec2 dir = glm::normalize(pos - closest);
-    dir *= (radius - dist);
-    return { true, dir };
+void ChunkTable::push(const glm::ivec2 &pos, MeshMask meshMask) {
+    chunkPos.push_back(pos);
+    meshMasks.push_back(meshMask);
 }
 
-Hitbox shrekrooms::Hitbox::offset(const glm::vec2& offset) {
-    return Hitbox {
-        posMin + offset,
-        posMax + offset
-    };
+void ChunkTable::remove(size_t index) {
+    chunkPos[index] = chunkPos.back();
+    meshMasks[index] = meshMasks.back();
+    chunkPos.pop_back();
+    meshMasks.pop_back();
 }
 
-/*
- * class shrekrooms::Chunk
-*/
-
-std::array<Hitbox, Chunk::s_wallCount> Chunk::s_hitboxes { };
-bool Chunk::s_hitboxesGenerated = false;
-
-Chunk::Chunk(const gl::GLContext &glc, const glm::ivec2 &chunkPos, const maze::MazeNode &node) :
-        m_uniman(glc.getUniformManager()), m_meshman(glc.getMeshManager()), m_chunkPos(chunkPos), m_meshes(), m_walls() {
-    if (!s_hitboxesGenerated) {
-        s_genHitboxes();
-        s_hitboxesGenerated = true;
-    }
-
-    m_setWalls(node);
-    m_addMeshes();
-
-    m_chunkOffset = defines::world::chunkSize * static_cast<glm::vec2>(m_chunkPos);
-    if ((m_chunkPos.x + m_chunkPos.y) % 2 == 0)
-        m_chunkOffset += glm::vec2 { defines::epsilon, defines::epsilon };
-
-    m_chunkTranslateMat = glm::translate(defines::mat4identity, { m_chunkOffset.x, 0.0f, m_chunkOffset.y });
+ChunkTable::MeshMask ChunkTable::s_getMeshMask(const glm::ivec2 &pos, const maze::MazeNode &node) {
+    // Every wall is owned by the chunk on its x-/z- side, so only border chunks keep x-/z- walls
+    MeshMask mask = 0b00001;
+    if (node.hasWall(maze::Direction::XPos))                 mask |= 0b00010;
+    if (node.hasWall(maze::Direction::XNeg) && pos.x == 0)   mask |= 0b00100;
+    if (node.hasWall(maze::Direction::ZPos))                 mask |= 0b01000;
+    if (node.hasWall(maze::Direction::ZNeg) && pos.y == 0)   mask |= 0b10000;
+    return mask;
 }
 
-void Chunk::draw() const {
-    for (MeshManager::Mesh mesh : m_meshes) {
-        m_uniman.setTranslateMatrix(m_chunkTranslateMat);
-        m_meshman.renderMesh(mesh);
-    }
+glm::vec2 ChunkTable::s_getOffset(const glm::ivec2 &pos) {
+    return defines::world::chunkSize * static_cast<glm::vec2>(pos) + s_getNudge(pos);
 }
 
-bool Chunk::playerCanCollide(const glm::vec2 &pos) const {
-    glm::vec2 chDiff = glm::abs(m_chunkPos - worldToChunkCoords(pos));
-    return (std::max(chDiff.x, chDiff.y) <= 1);
+glm::vec2 ChunkTable::s_getNudge(const glm::ivec2 &pos) {
+    if ((pos.x + pos.y) % 2 == 0)
+        return { defines::epsilon, defines::epsilon };
+    return { 0.0f, 0.0f };
 }
 
-void Chunk::addThisToCollision(Collision &coll, const glm::vec2 &pos, float radius) const {
+void ChunkTable::s_addWallHitboxes(HitboxBatch &batch, const glm::ivec2 &pos, MeshMask meshMask) {
+    const std::array<Hitbox, s_wallCount> &hitboxes = s_getHitboxes();
+
+    const glm::vec2 offset = s_getOffset(pos);
     for (size_t i = 0; i < s_wallCount; i++) {
-        if (m_walls[i])
-            coll.addOtherCollision(
-                s_hitboxes[i]
-                    .offset(m_chunkOffset)
-                    .getCircleIntersection(pos, radius)
-            );
+        if (meshMask & (1 << (i + 1)))
+            batch.push(hitboxes[i].offset(offset));
     }
 }
 
-Collision Chunk::getCollision(const glm::vec2 &pos, float radius) const {
-    Collision res { };
-    addThisToCollision(res, pos, radius);
-    return res;
+Box ChunkTable::s_getBox(const glm::ivec2 &chunkMin, const glm::ivec2 &chunkMax, const WorldPos &origin) {
+    // Walls on the border reach past the chunk by half their thickness
+    const float xzmax = 0.5f * defines::world::chunkSize + defines::world::wallThicknessHalf + defines::epsilon;
+    const float ymax = 0.5f * defines::world::chunkHeight;
+    return {
+        WorldPos { chunkMin, { -xzmax, -ymax, -xzmax } }.relativeTo(origin),
+        WorldPos { chunkMax, {  xzmax,  ymax,  xzmax } }.relativeTo(origin)
+    };
 }
 
-void Chunk::m_setWalls(const maze::MazeNode &node) {
-    m_walls[0] = node.hasWall(maze::Direction::XPos);
-    m_walls[1] = node.hasWall(maze::Direction::XNeg);
-    m_walls[2] = node.hasWall(maze::Direction::ZPos);
-    m_walls[3] = node.hasWall(maze::Direction::ZNeg);
+const std::array<Hitbox, ChunkTable::s_wallCount> &ChunkTable::s_getHitboxes() {
+    static const std::array<Hitbox, s_wallCount> hitboxes = s_genHitboxes();
+    return hitboxes;
 }
 
-void Chunk::m_addMeshes() {
-    // floor
-    m_meshes[0] = MeshManager::Mesh::ChunkFloor;
-
-    // walls
-    if (m_walls[0]) m_meshes[1] = MeshManager::Mesh::ChunkWallXPos;
-    if (m_walls[1]) m_meshes[2] = MeshManager::Mesh::ChunkWallXNeg;
-    if (m_walls[2]) m_meshes[3] = MeshManager::Mesh::ChunkWallZPos;
-    if (m_walls[3]) m_meshes[4] = MeshManager::Mesh::ChunkWallZNeg;
-}
+std::array<Hitbox, ChunkTable::s_wallCount> ChunkTable::s_genHitboxes() {
+    std::array<Hitbox, s_wallCount> hitboxes;
 
-void Chunk::s_genHitboxes() {
     const float pmax = 0.5f * defines::world::chunkSize;
     const float wmax = pmax - defines::world::wallThicknessHalf;
     const float gmax = pmax + defines::world::wallThicknessHalf - 2.0f*defines::epsilon;
+    const float nmax = pmax + defines::world::wallThicknessHalf;
 
-    // x+
-    s_hitboxes[0] = Hitbox {
+    // x+ (shared with the x+ neighbour)
+    hitboxes[0] = Hitbox {
         {  wmax, -gmax },
-        {  pmax,  gmax }
+        {  nmax,  gmax }
     };
     // x-
-    s_hitboxes[1] = Hitbox {
+    hitboxes[1] = Hitbox {
         { -pmax, -gmax },
         { -wmax,  gmax }
     };
-    // z+
-    s_hitboxes[2] = Hitbox {
+    // z+ (shared with the z+ neighbour)
+    hitboxes[2] = Hitbox {
         { -gmax,  wmax },
-        {  gmax,  gmax }
+        {  gmax,  nmax }
     };
     // z-
-    s_hitboxes[3] = Hitbox {
+    hitboxes[3] = Hitbox {
         { -gmax, -gmax },
         {  gmax, -wmax }
     };
+    return hitboxes;
 }
 
 
@@ -169,29 +109,107 @@ void Chunk::s_genHitboxes() {
  * class shrekrooms::World
 */
 
-World::World(const gl::GLContext &glc, const maze::Maze &maze) :
-        m_glc(glc), m_uniman(glc.getUniformManager()), m_meshman(glc.getMeshManager()), m_maze(maze) {
-    m_chunks.reserve(defines::world::chunksCountWidth*defines::world::chunksCountWidth);
-
-    for (int x = 0; x < defines::world::chunksCountWidth; x++) {
-        for (int y = 0; y < defines::world::chunksCountWidth; y++) {
-            m_chunks.emplace_back(m_glc, glm::ivec2 { x, y }, m_maze.getNode({ x, y }));
+World::World(const maze::Maze &maze, jobs::JobSystem &jobs) :
+        m_maze(maze) {
+    const int size = static_cast<int>(m_maze.getSize());
+
+    // Collision covers the whole maze, whatever the renderer has loaded.
+    // Columns are gathered in parallel and joined in order, so the result doesn't depend on scheduling
+    std::vector<HitboxBatch> columns(size);
+    jobs.parallelFor(0, size, 1, [this, size, &columns](size_t x) {
+        columns[x].reserve(2 * size);
+        for (int y = 0; y < size; y++) {
+            const glm::ivec2 pos { static_cast<int>(x), y };
+            ChunkTable::s_addWallHitboxes(columns[x], pos, ChunkTable::s_getMeshMask(pos, m_maze.getNode(pos)));
         }
+    });
+
+    HitboxBatch walls;
+    walls.reserve(2 * size*size);
+    for (const HitboxBatch &column : columns) {
+        for (size_t i = 0; i < column.size(); i++)
+            walls.push(column.get(i));
     }
+    m_walls.build(walls);
 }
 
-void World::draw() const {
-    m_glc.enableShader();
-
-    for (const Chunk &ch : m_chunks)
-        ch.draw();
+const maze::Maze &World::getMaze() const {
+    return m_maze;
 }
 
 Collision World::getCollision(const glm::vec2 &pos, float radius) const {
     Collision res { };
-    for (const Chunk &ch : m_chunks) {
-        if (ch.playerCanCollide(pos))
-            ch.addThisToCollision(res, pos, radius);
-    }
+    m_walls.addCircleIntersections(res, pos, radius);
     return res;
 }
+
+void World::getCollisions(const glm::vec2 *pos, const float *radius, size_t count, Collision *res) const {
+    for (size_t i = 0; i < count; i++) {
+        res[i] = { };
+        m_walls.addCircleIntersections(res[i], pos[i], radius[i]);
+    }
+}
+
+WorldPos World::moveCircle(const WorldPos &pos, const glm::vec2 &delta, float radius) const {
+    static constexpr int maxSlides = 4;
+    // Distance kept from a wall after an impact, so the next sweep does not start inside it
+    static const float skin = defines::epsilon;
+
+    // The walls are in world coordinates, only the distance travelled is added to pos
+    const glm::vec3 start3 = pos.toWorld();
+    const glm::vec2 start { start3.x, start3.z };
+    glm::vec2 moved { 0.0f, 0.0f };
+    glm::vec2 remaining = delta;
+    for (int i = 0; i < maxSlides; i++) {
+        const float len = glm::length(remaining);
+        if (len < skin)
+            break;
+
+        const glm::vec2 dir = remaining / len;
+        RayHit hit = m_walls.sweepCircle(start + moved, dir, len + skin, radius);
+        if (!hit.isHit) {
+            moved += remaining;
+            break;
+        }
+
+        const float travel = glm::clamp(hit.dist - skin, 0.0f, len);
+        moved += dir * travel;
+
+        // Drop the part of the leftover movement that goes into the wall
+        remaining = dir * (len - travel);
+        remaining -= hit.normal * glm::dot(remaining, hit.normal);
+    }
+
+    // Resolves whatever is left, e.g. a spawn point inside a wall's reach
+    Collision coll = getCollision(start + moved, radius);
+    if (coll.isColliding)
+        moved += coll.cancelVector;
+    return pos + glm::vec3 { moved.x, 0.0f, moved.y };
+}
+
+RayHit World::raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const {
+    maze::MazeRayHit hit = m_maze.raycast(origin / defines::world::chunkSize, dir, maxDist / defines::world::chunkSize);
+    if (!hit.isHit)
+        return { };
+    if (hit.wall == maze::Direction::Null)
+        return { 0.0f, { 0.0f, 0.0f } };
+
+    // The maze hit is on the chunk border, the wall face is half a wall thickness closer
+    const glm::vec2 normal = -static_cast<glm::vec2>(maze::getDirectionVector(hit.wall));
+    const float cosine = std::abs(glm::dot(dir, normal));
+    const float dist = hit.dist * defines::world::chunkSize - defines::world::wallThicknessHalf / cosine;
+    return { std::max(dist, 0.0f), normal };
+}
+
+void World::raycasts(const glm::vec2 *origins, const glm::vec2 *dirs, size_t count, float maxDist, RayHit *res) const {
+    for (size_t i = 0; i < count; i++)
+        res[i] = raycast(origins[i], dirs[i], maxDist);
+}
+
+bool World::hasLineOfSight(const glm::vec2 &from, const glm::vec2 &to) const {
+    return m_maze.hasLineOfSight(from / defines::world::chunkSize, to / defines::world::chunkSize);
+}
+
+const WallBVH &World::getWalls() const {
+    return m_walls;
+}
@@ -1,94 +1,80 @@
 #pragma once
 
 #include "defines.hpp"
-#include "glc.hpp"
+#include "world_pos.hpp"
 #include "maze.hpp"
+#include "collision.hpp"
+#include "frustum.hpp"
+#include "bvh.hpp"
+#include "jobs.hpp"
 
 
 namespace shrekrooms {
 
 
-glm::ivec2 worldToChunkCoords(const glm::vec2 &pos);
-glm::ivec2 worldToChunkCoords(const glm::vec3 &pos);
+/*
+ * Chunks as parallel arrays, the translation of a chunk is derived from its position.
+ * Mesh mask bits:
+ * 0: floor
+ * 1: x+
+ * 2: x- (maze border only)
+ * 3: z+
+ * 4: z- (maze border only)
+*/
+struct ChunkTable {
+    using MeshMask = uint8_t;
 
+    static constexpr size_t s_wallCount = 4;
+    static constexpr size_t s_meshCount = s_wallCount + 1;
 
-struct Collision {
-    bool isColliding;
-    glm::vec2 cancelVector;
-
-    Collision();
-    Collision(bool isColliding, glm::vec2 cancelVector);
-
-    void addOtherCollision(const Collision &coll);
-
-};
-
-
-struct Hitbox {
-    glm::vec2 posMin, posMax;
-
-    Hitbox();
-    Hitbox(const glm::vec2 &posMin, const glm::vec2 &posMax);
+    std::vector<glm::ivec2> chunkPos;
+    std::vector<MeshMask> meshMasks;
 
-    bool isInside(const glm::vec2 &pos) const;
+    size_t size() const;
+    void reserve(size_t count);
+    void push(const glm::ivec2 &pos, MeshMask meshMask);
+    // Moves the last chunk into index
+    void remove(size_t index);
 
-    Collision getCircleIntersection(const glm::vec2 &pos, float radius) const;
+    static MeshMask s_getMeshMask(const glm::ivec2 &pos, const maze::MazeNode &node);
+    static glm::vec2 s_getOffset(const glm::ivec2 &pos);
+    // Every other chunk is moved by epsilon, so coplanar faces of neighbours don't z-fight
+    static glm::vec2 s_getNudge(const glm::ivec2 &pos);
+    static void s_addWallHitboxes(HitboxBatch &batch, const glm::ivec2 &pos, MeshMask meshMask);
+    // Bounds of the chunks [chunkMin; chunkMax] including walls, relative to origin
+    static Box s_getBox(const glm::ivec2 &chunkMin, const glm::ivec2 &chunkMax, const WorldPos &origin);
 
-    Hitbox offset(const glm::vec2 &offset);
+protected:
+    // Generated on first use, safe to call from several threads
+    static const std::array<Hitbox, s_wallCount> &s_getHitboxes();
+    static std::array<Hitbox, s_wallCount> s_genHitboxes();
 
 };
 
 
-class Chunk {
+class World {
 public:
-    Chunk(const gl::GLContext &glc, const glm::ivec2 &chunkPos, const maze::MazeNode &node);
-    
-    void draw() const;
+    World(const maze::Maze &maze, jobs::JobSystem &jobs);
 
-    bool playerCanCollide(const glm::vec2 &pos) const;
-    void addThisToCollision(Collision &coll, const glm::vec2 &pos, float radius) const;
-    Collision getCollision(const glm::vec2 &pos, float radius) const;
+    const maze::Maze &getMaze() const;
 
-protected:
-    static constexpr size_t s_wallCount = 4;
-    static std::array<Hitbox, s_wallCount> s_hitboxes;
-    static bool s_hitboxesGenerated;
-
-    const UniformManager &m_uniman;
-    const MeshManager &m_meshman;
-    glm::ivec2 m_chunkPos;
-    glm::vec2 m_chunkOffset;
-    glm::mat4 m_chunkTranslateMat;
-    std::array<MeshManager::Mesh, (s_wallCount + 1)> m_meshes;
-    /*
-     * 0: x+
-     * 1: x-
-     * 2: z+
-     * 3: z-
-    */
-    std::array<bool, s_wallCount> m_walls;
-
-    void m_setWalls(const maze::MazeNode &node);
-    void m_addMeshes();
-    void s_genHitboxes();
-
-};
+    Collision getCollision(const glm::vec2 &pos, float radius) const;
+    // res has to hold count elements
+    void getCollisions(const glm::vec2 *pos, const float *radius, size_t count, Collision *res) const;
 
+    // Moves a circle by delta, stopping at walls and sliding along them
+    WorldPos moveCircle(const WorldPos &pos, const glm::vec2 &delta, float radius) const;
 
-class World {
-public:
-    World(const gl::GLContext &glc, const maze::Maze &maze);
+    // Grid raycasts on the maze walls, cost grows with the number of chunks crossed
+    RayHit raycast(const glm::vec2 &origin, const glm::vec2 &dir, float maxDist) const;
+    void raycasts(const glm::vec2 *origins, const glm::vec2 *dirs, size_t count, float maxDist, RayHit *res) const;
+    bool hasLineOfSight(const glm::vec2 &from, const glm::vec2 &to) const;
 
-    void draw() const;
-    
-    Collision getCollision(const glm::vec2 &pos, float radius) const;
+    const WallBVH &getWalls() const;
 
 protected:
-    const gl::GLContext &m_glc;
-    const UniformManager &m_uniman;
-    const MeshManager &m_meshman;
     const maze::Maze &m_maze;
-    std::vector<Chunk> m_chunks;
+    WallBVH m_walls;
 
 };
 
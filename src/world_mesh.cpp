@@ -0,0 +1,207 @@
+#include "world_mesh.hpp"
+
+using namespace shrekrooms;
+
+
+/*
+ * class shrekrooms::WorldMesh
+*/
+
+WorldMesh::WorldMesh(const MeshManager &meshman, gl::StateCache &state, const ChunkMeshes &chunkMeshes, const glm::ivec2 &anchor, size_t maxRegions) :
+        m_meshman(meshman), m_state(state), m_anchor(anchor), m_visibleChunkCount(0), m_culledRegionCount(0) {
+    const size_t regionChunks = defines::world::bakeRegionSize * defines::world::bakeRegionSize;
+
+    // A slot holds a region with every chunk loaded and every mesh present
+    for (size_t bit = 0; bit < chunkMeshes.size(); bit++) {
+        const gl::Texture texture = meshman.getTexture(chunkMeshes[bit]);
+        auto group = std::find_if(m_groups.begin(), m_groups.end(), [&](const TextureGroup &group) {
+            return group.texture == texture;
+        });
+        if (group == m_groups.end()) {
+            m_groups.push_back({});
+            group = std::prev(m_groups.end());
+            group->texture = texture;
+        }
+        group->meshes.push_back(chunkMeshes[bit]);
+        group->meshBits.push_back(bit);
+        group->slotCapacity += regionChunks * meshman.getVertices(chunkMeshes[bit]).size() / MeshManager::s_vertexStride;
+    }
+
+    GLint vertCount = 0;
+    for (TextureGroup &group : m_groups) {
+        group.base = vertCount;
+        group.slotCounts.assign(maxRegions, 0);
+        vertCount += group.slotCapacity * maxRegions;
+    }
+
+    for (size_t slot = maxRegions; slot-- > 0; )
+        m_freeSlots.push_back(slot);
+    m_slotRegions.resize(maxRegions);
+    m_slotChunkCounts.resize(maxRegions, 0);
+
+    glGenVertexArrays(1, &m_geometry.vao);
+    m_state.bindVertexArray(m_geometry.vao);
+    glGenBuffers(1, &m_geometry.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_geometry.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertCount*MeshManager::s_vertexStride*sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+    MeshManager::s_setVertexAttributes();
+    m_geometry.vertCount = vertCount;
+}
+
+const glm::ivec2 &WorldMesh::getAnchor() const {
+    return m_anchor;
+}
+
+size_t WorldMesh::getRegionCount() const {
+    return m_regionSlots.size();
+}
+
+void WorldMesh::cull(const std::function<bool(const glm::ivec2 &, const glm::ivec2 &)> &isVisible) {
+    const int regionSize = defines::world::bakeRegionSize;
+
+    m_clearDrawLists();
+    for (const auto &[key, slot] : m_regionSlots) {
+        const glm::ivec2 chunkMin = regionSize * m_slotRegions[slot];
+        if (!isVisible(chunkMin, chunkMin + (regionSize - 1)))
+            m_culledRegionCount++;
+        else
+            m_addDrawSlot(slot);
+    }
+}
+
+size_t WorldMesh::getVisibleChunkCount() const {
+    return m_visibleChunkCount;
+}
+
+size_t WorldMesh::getCulledRegionCount() const {
+    return m_culledRegionCount;
+}
+
+void WorldMesh::markDirty(const glm::ivec2 &chunkPos) {
+    m_dirtyRegions.push_back(s_getRegion(chunkPos));
+}
+
+void WorldMesh::update(const ChunkTable &chunks) {
+    if (m_dirtyRegions.empty())
+        return;
+
+    // Resident chunks of every dirty region, gathered in one pass
+    std::unordered_map<uint64_t, std::vector<size_t>> regionChunks;
+    for (const glm::ivec2 &region : m_dirtyRegions)
+        regionChunks[getChunkKey(region)];
+    for (size_t i = 0; i < chunks.size(); i++) {
+        auto it = regionChunks.find(getChunkKey(s_getRegion(chunks.chunkPos[i])));
+        if (it != regionChunks.end())
+            it->second.push_back(i);
+    }
+
+    for (const glm::ivec2 &region : m_dirtyRegions) {
+        auto it = regionChunks.find(getChunkKey(region));
+        // Already baked, the region was marked more than once
+        if (it == regionChunks.end())
+            continue;
+        m_bakeRegion(region, chunks, it->second);
+        regionChunks.erase(it);
+    }
+    m_dirtyRegions.clear();
+
+    m_buildDrawLists();
+}
+
+void WorldMesh::draw(const UniformManager &uniman) const {
+    m_state.bindVertexArray(m_geometry.vao);
+
+    for (const TextureGroup &group : m_groups) {
+        if (group.drawCounts.empty())
+            continue;
+        uniman.useTexture(group.texture);
+        glMultiDrawArrays(GL_TRIANGLES, group.drawFirsts.data(), group.drawCounts.data(), group.drawCounts.size());
+    }
+}
+
+glm::ivec2 WorldMesh::s_getRegion(const glm::ivec2 &chunkPos) {
+    return static_cast<glm::ivec2>(glm::floor(static_cast<glm::vec2>(chunkPos) / static_cast<float>(defines::world::bakeRegionSize)));
+}
+
+void WorldMesh::m_bakeRegion(const glm::ivec2 &region, const ChunkTable &chunks, const std::vector<size_t> &chunkIds) {
+    static constexpr size_t stride = MeshManager::s_vertexStride;
+
+    const uint64_t key = getChunkKey(region);
+    auto slotIt = m_regionSlots.find(key);
+
+    // Unloaded, its slot goes back to the pool
+    if (chunkIds.empty()) {
+        if (slotIt == m_regionSlots.end())
+            return;
+        for (TextureGroup &group : m_groups)
+            group.slotCounts[slotIt->second] = 0;
+        m_freeSlots.push_back(slotIt->second);
+        m_regionSlots.erase(slotIt);
+        return;
+    }
+
+    if (slotIt == m_regionSlots.end()) {
+        if (m_freeSlots.empty())
+            throw error { "world_mesh.cpp", "shrekrooms::WorldMesh::m_bakeRegion", "Ran out of region slots" };
+        slotIt = m_regionSlots.emplace(key, m_freeSlots.back()).first;
+        m_freeSlots.pop_back();
+    }
+    const size_t slot = slotIt->second;
+    m_slotRegions[slot] = region;
+    m_slotChunkCounts[slot] = chunkIds.size();
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_geometry.vbo);
+
+    std::vector<float> verts;
+    for (TextureGroup &group : m_groups) {
+        verts.clear();
+        for (size_t id : chunkIds) {
+            const glm::ivec2 &chunkPos = chunks.chunkPos[id];
+            const glm::vec2 nudge = ChunkTable::s_getNudge(chunkPos);
+            const glm::vec3 offset = WorldPos { chunkPos, { nudge.x, 0.0f, nudge.y } }.relativeTo({ m_anchor, { 0.0f, 0.0f, 0.0f } });
+
+            for (size_t mesh = 0; mesh < group.meshes.size(); mesh++) {
+                if (!(chunks.meshMasks[id] & (1 << group.meshBits[mesh])))
+                    continue;
+
+                const std::vector<float> &src = m_meshman.getVertices(group.meshes[mesh]);
+                for (size_t v = 0; v < src.size(); v += stride) {
+                    verts.push_back(src[v] + offset.x);
+                    verts.push_back(src[v + 1] + offset.y);
+                    verts.push_back(src[v + 2] + offset.z);
+                    verts.push_back(src[v + 3]);
+                    verts.push_back(src[v + 4]);
+                }
+            }
+        }
+
+        const GLint first = group.base + slot * group.slotCapacity;
+        glBufferSubData(GL_ARRAY_BUFFER, first*stride*sizeof(GLfloat), verts.size()*sizeof(GLfloat), verts.data());
+        group.slotCounts[slot] = verts.size() / stride;
+    }
+}
+
+void WorldMesh::m_clearDrawLists() {
+    for (TextureGroup &group : m_groups) {
+        group.drawFirsts.clear();
+        group.drawCounts.clear();
+    }
+    m_visibleChunkCount = 0;
+    m_culledRegionCount = 0;
+}
+
+void WorldMesh::m_addDrawSlot(size_t slot) {
+    for (TextureGroup &group : m_groups) {
+        if (group.slotCounts[slot] == 0)
+            continue;
+        group.drawFirsts.push_back(group.base + slot * group.slotCapacity);
+        group.drawCounts.push_back(group.slotCounts[slot]);
+    }
+    m_visibleChunkCount += m_slotChunkCounts[slot];
+}
+
+void WorldMesh::m_buildDrawLists() {
+    m_clearDrawLists();
+    for (const auto &[key, slot] : m_regionSlots)
+        m_addDrawSlot(slot);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "defines.hpp"
+#include "managers.hpp"
+#include "world.hpp"
+
+
+namespace shrekrooms {
+
+
+/*
+ * Resident chunks baked into a single vertex buffer, grouped by texture,
+ * so the whole maze draws with one call per texture.
+ * Chunks are baked in square regions, each owning a fixed slot of every
+ * texture range, so a region whose chunks change is rebaked on its own
+*/
+class WorldMesh {
+public:
+    using ChunkMeshes = std::array<MeshManager::Mesh, ChunkTable::s_meshCount>;
+
+    // Vertices are stored relative to the anchor chunk
+    WorldMesh(const MeshManager &meshman, gl::StateCache &state, const ChunkMeshes &chunkMeshes, const glm::ivec2 &anchor, size_t maxRegions);
+
+    const glm::ivec2 &getAnchor() const;
+    size_t getRegionCount() const;
+
+    // The region of the chunk is rebaked on the next update()
+    void markDirty(const glm::ivec2 &chunkPos);
+    void update(const ChunkTable &chunks);
+
+    // Only regions for which isVisible(chunkMin, chunkMax) holds are drawn until the next cull() or update()
+    void cull(const std::function<bool(const glm::ivec2 &, const glm::ivec2 &)> &isVisible);
+    size_t getVisibleChunkCount() const;
+    size_t getCulledRegionCount() const;
+
+    // Translation has to be set to the anchor
+    void draw(const UniformManager &uniman) const;
+
+protected:
+    // Chunk meshes sharing a texture
+    struct TextureGroup {
+        gl::Texture texture;
+        std::vector<MeshManager::Mesh> meshes;
+        std::vector<size_t> meshBits;
+        size_t slotCapacity;    // In vertices
+        GLint base;
+        std::vector<GLsizei> slotCounts;
+        // Non-empty slots, rebuilt on update()
+        std::vector<GLint> drawFirsts;
+        std::vector<GLsizei> drawCounts;
+    };
+
+    const MeshManager &m_meshman;
+    gl::StateCache &m_state;
+    glm::ivec2 m_anchor;
+    gl::Geometry m_geometry;
+    std::vector<TextureGroup> m_groups;
+    std::unordered_map<uint64_t, size_t> m_regionSlots;
+    std::vector<size_t> m_freeSlots;
+    std::vector<glm::ivec2> m_slotRegions;
+    std::vector<size_t> m_slotChunkCounts;
+    std::vector<glm::ivec2> m_dirtyRegions;
+    size_t m_visibleChunkCount;
+    size_t m_culledRegionCount;
+
+    static glm::ivec2 s_getRegion(const glm::ivec2 &chunkPos);
+
+    void m_bakeRegion(const glm::ivec2 &region, const ChunkTable &chunks, const std::vector<size_t> &chunkIds);
+    void m_clearDrawLists();
+    void m_addDrawSlot(size_t slot);
+    // Every baked region
+    void m_buildDrawLists();
+
+};
+
+
+} // namespace shrekrooms
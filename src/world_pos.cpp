@@ -0,0 +1,76 @@
+#include "world_pos.hpp"
+
+using namespace shrekrooms;
+
+
+glm::ivec2 shrekrooms::worldToChunkCoords(const glm::vec2& pos) {
+    static const glm::vec2 cornerDiff { 0.5f * defines::world::chunkSize, 0.5f * defines::world::chunkSize };
+    // Rounded down, not towards zero, so chunks left of and below the origin work too
+    glm::vec2 tmp = glm::floor((pos + cornerDiff) / defines::world::chunkSize);
+    return static_cast<glm::ivec2>(tmp);
+}
+
+glm::ivec2 shrekrooms::worldToChunkCoords(const glm::vec3& pos) {
+    return worldToChunkCoords({ pos.x, pos.z });
+}
+
+glm::vec3 shrekrooms::chunkToWorldCoords(const glm::ivec2 &pos) {
+    const glm::vec2 tmp = defines::world::chunkSize * static_cast<glm::vec2>(pos);
+    return { tmp.x, 0.0f, tmp.y };
+}
+
+uint64_t shrekrooms::getChunkKey(const glm::ivec2 &pos) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32) | static_cast<uint32_t>(pos.y);
+}
+
+
+/*
+ * struct shrekrooms::WorldPos
+*/
+
+WorldPos::WorldPos() :
+    chunk(0, 0), local(0.0f, 0.0f, 0.0f) { }
+
+WorldPos::WorldPos(const glm::ivec2 &chunk, const glm::vec3 &local) :
+    chunk(chunk), local(local) { }
+
+WorldPos WorldPos::s_fromWorld(const glm::vec3 &pos) {
+    const glm::ivec2 chunk = worldToChunkCoords(pos);
+    return { chunk, pos - chunkToWorldCoords(chunk) };
+}
+
+glm::vec3 WorldPos::toWorld() const {
+    return chunkToWorldCoords(chunk) + local;
+}
+
+glm::vec3 WorldPos::relativeTo(const WorldPos &origin) const {
+    return chunkToWorldCoords(chunk - origin.chunk) + (local - origin.local);
+}
+
+WorldPos &WorldPos::operator +=(const glm::vec3 &delta) {
+    local += delta;
+    const glm::ivec2 shift = worldToChunkCoords(local);
+    if (shift.x != 0 || shift.y != 0) {
+        chunk += shift;
+        local -= chunkToWorldCoords(shift);
+    }
+    return *this;
+}
+
+WorldPos WorldPos::operator +(const glm::vec3 &delta) const {
+    WorldPos res = *this;
+    res += delta;
+    return res;
+}
+
+bool WorldPos::operator ==(const WorldPos &other) const {
+    return chunk == other.chunk && local == other.local;
+}
+
+bool WorldPos::operator !=(const WorldPos &other) const {
+    return !(*this == other);
+}
+
+WorldPos WorldPos::s_mix(const WorldPos &a, const WorldPos &b, float alpha) {
+    return a + alpha * b.relativeTo(a);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defines.hpp"
+
+
+namespace shrekrooms {
+
+
+glm::ivec2 worldToChunkCoords(const glm::vec2 &pos);
+glm::ivec2 worldToChunkCoords(const glm::vec3 &pos);
+// Centre of the chunk on the floor
+glm::vec3 chunkToWorldCoords(const glm::ivec2 &pos);
+// Unique per chunk, for hash maps
+uint64_t getChunkKey(const glm::ivec2 &pos);
+
+
+/*
+ * Position as the chunk it lies in plus a float offset from that chunk's centre.
+ * Differences are taken on the chunks in integers first, so they keep full
+ * precision however far both positions lie from the world origin
+*/
+struct WorldPos {
+    glm::ivec2 chunk;
+    glm::vec3 local;
+
+    WorldPos();
+    WorldPos(const glm::ivec2 &chunk, const glm::vec3 &local);
+
+    static WorldPos s_fromWorld(const glm::vec3 &pos);
+    glm::vec3 toWorld() const;
+
+    // this - origin
+    glm::vec3 relativeTo(const WorldPos &origin) const;
+
+    // Moves into the chunk the result lies in, so local stays within half a chunk
+    WorldPos &operator +=(const glm::vec3 &delta);
+    WorldPos operator +(const glm::vec3 &delta) const;
+    bool operator ==(const WorldPos &other) const;
+    bool operator !=(const WorldPos &other) const;
+
+    static WorldPos s_mix(const WorldPos &a, const WorldPos &b, float alpha);
+
+};
+
+
+} // namespace shrekrooms